@@ -0,0 +1,272 @@
+#ifndef TRUSS_MAINT_PROF_H_
+#define TRUSS_MAINT_PROF_H_
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace truss_maint {
+// the peak resident set size of the process so far in KB
+inline uint64_t PeakRssKb() {
+  rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  return ru.ru_maxrss;
+}
+// the current resident set size in KB, or 0 if unknown
+inline uint64_t RssKb() {
+  FILE* f = fopen("/proc/self/statm", "r");
+  if (nullptr == f) return 0;
+  unsigned long long pages = 0, resident = 0;
+  const bool ok = 2 == fscanf(f, "%llu %llu", &pages, &resident);
+  fclose(f);
+  return ok ? resident * (sysconf(_SC_PAGESIZE) / 1024) : 0;
+}
+// the bytes held by a vector, and by a vector of vectors with their elements
+template <typename T>
+uint64_t Bytes(const std::vector<T>& v) {
+  return v.capacity() * sizeof(T);
+}
+inline uint64_t Bytes(const std::vector<bool>& v) { return v.capacity() / 8; }
+template <typename T>
+uint64_t Bytes(const std::vector<std::vector<T>>& v) {
+  uint64_t bytes = v.capacity() * sizeof(std::vector<T>);
+  for (const auto& inner : v) bytes += Bytes(inner);
+  return bytes;
+}
+// the bytes held by each structure, by name
+typedef std::vector<std::pair<std::string, uint64_t>> MemoryT;
+
+// an HDR-style histogram of latencies in ns: the values below 2^kSubBits
+// are counted exactly, and each larger power of two is split into
+// 2^kSubBits buckets, so a percentile is off by less than 2^-kSubBits
+class Histogram final {
+ public:
+  void Record(const uint64_t ns) {
+    const size_t b = Bucket(ns);
+    if (b >= counts_.size()) counts_.resize(b + 1);
+    ++counts_[b];
+    if (0 == count_ || ns < min_) min_ = ns;
+    max_ = std::max(max_, ns);
+    sum_ += ns;
+    ++count_;
+  }
+  uint64_t count() const { return count_; }
+  // the nearest-rank percentile p, as the upper end of its bucket
+  uint64_t Percentile(const double p) const {
+    const uint64_t rank = std::max<uint64_t>(
+        1, static_cast<uint64_t>(p / 100 * count_ + 0.999999));
+    uint64_t seen = 0;
+    for (size_t b = 0; b < counts_.size(); ++b) {
+      seen += counts_[b];
+      if (seen >= rank) return std::min(max_, Upper(b));
+    }
+    return max_;
+  }
+  // the count, the mean, the min, p50, p90, p99, p999 and the max in ns
+  std::string Json() const {
+    char buf[256];
+    snprintf(buf, sizeof buf,
+             "{\"count\": %" PRIu64 ", \"mean_ns\": %.1f, \"min_ns\": %" PRIu64
+             ", \"p50_ns\": %" PRIu64 ", \"p90_ns\": %" PRIu64
+             ", \"p99_ns\": %" PRIu64 ", \"p999_ns\": %" PRIu64
+             ", \"max_ns\": %" PRIu64 "}", count_,
+             count_ ? static_cast<double>(sum_) / count_ : 0.0, min_,
+             Percentile(50), Percentile(90), Percentile(99), Percentile(99.9),
+             max_);
+    return buf;
+  }
+
+ private:
+  static constexpr int kSubBits = 5;
+  static size_t Bucket(const uint64_t v) {
+    if (v < (uint64_t{1} << kSubBits)) return v;
+    const int e = 63 - __builtin_clzll(v);
+    return (size_t{1} << kSubBits) * (e - kSubBits + 1) +
+           ((v >> (e - kSubBits)) - (uint64_t{1} << kSubBits));
+  }
+  static uint64_t Upper(const size_t b) {
+    if (b < (size_t{1} << kSubBits)) return b;
+    const int shift = b / (size_t{1} << kSubBits) - 1;
+    const uint64_t sub = b % (size_t{1} << kSubBits);
+    return (((uint64_t{1} << kSubBits) + sub + 1) << shift) - 1;
+  }
+  std::vector<uint64_t> counts_;
+  uint64_t count_ = 0;
+  uint64_t sum_ = 0;
+  uint64_t min_ = 0;
+  uint64_t max_ = 0;
+};
+
+// the n slowest of a series of events, each described by a JSON object
+class Slowest final {
+ public:
+  explicit Slowest(const size_t n) : n_(n) {}
+  // whether an event taking @ns would be kept, so that describing the
+  // other events can be skipped
+  bool Wants(const uint64_t ns) const {
+    return n_ > 0 && (kept_.size() < n_ || ns > kept_.front().first);
+  }
+  void Add(const uint64_t ns, const std::string& json) {
+    if (!Wants(ns)) return;
+    if (kept_.size() == n_) {
+      std::pop_heap(kept_.begin(), kept_.end(), Slower);
+      kept_.pop_back();
+    }
+    kept_.push_back({ns, json});
+    std::push_heap(kept_.begin(), kept_.end(), Slower);
+  }
+  // the kept events, the slowest first
+  std::vector<std::pair<uint64_t, std::string>> Sorted() const {
+    auto sorted = kept_;
+    std::sort(sorted.begin(), sorted.end(), Slower);
+    return sorted;
+  }
+
+ private:
+  // the heap keeps the fastest kept event on top
+  static bool Slower(const std::pair<uint64_t, std::string>& a,
+                     const std::pair<uint64_t, std::string>& b) {
+    return a.first > b.first;
+  }
+  size_t n_;
+  std::vector<std::pair<uint64_t, std::string>> kept_;
+};
+
+// the wall time of the phases of a run and its memory use, by layer; a
+// layer of -1 stands for the phases before the first layer
+class Profile final {
+ public:
+  struct Phase final {
+    std::string name;
+    int64_t layer;
+    double ms;
+    uint64_t rss_kb;   // the RSS at the end of the phase
+    uint64_t peak_kb;  // the RSS high-water at the end of the phase
+  };
+
+  Profile() : last_(std::chrono::steady_clock::now()) {}
+  // end the phase @name of layer @layer, which began at the end of the
+  // previous phase or at the last Restart
+  void Mark(const std::string& name, const int64_t layer) {
+    const auto now = std::chrono::steady_clock::now();
+    Add(name, layer,
+        std::chrono::duration<double, std::milli>(now - last_).count());
+    last_ = now;
+  }
+  void Restart() { last_ = std::chrono::steady_clock::now(); }
+  // add a phase timed elsewhere; the parts of a phase named "p" are named
+  // "p.part" and are added besides it
+  void Add(const std::string& name, const int64_t layer, const double ms) {
+    phases_.push_back({name, layer, ms, RssKb(), PeakRssKb()});
+  }
+  // the memory held by the structures of layer @layer
+  void Memory(const int64_t layer, const MemoryT& mem) {
+    memory_.push_back({layer, mem});
+  }
+  // the latencies of the operations @op of layer @layer, with the slowest
+  void Latency(const int64_t layer, const std::string& op,
+               const Histogram& hist, const Slowest& slowest) {
+    latency_.push_back({layer, op, hist, slowest.Sorted()});
+  }
+  // print the phases and the memory of a layer
+  void Print(const int64_t layer) const {
+    if (layer < 0) {
+      printf("phases:");
+    } else {
+      printf("phases of layer %" PRId64 ":", layer);
+    }
+    uint64_t peak = 0;
+    for (const auto& p : phases_) {
+      if (p.layer != layer) continue;
+      printf(" %s %.3f ms,", p.name.c_str(), p.ms);
+      peak = p.peak_kb;
+    }
+    printf(" RSS high-water %" PRIu64 " KB\n", peak);
+    for (const auto& lm : memory_) {
+      if (lm.first != layer) continue;
+      printf("memory:");
+      for (const auto& m : lm.second) {
+        printf(" %s %.3f MB,", m.first.c_str(), m.second / 1048576.0);
+      }
+      printf(" RSS %" PRIu64 " KB\n", RssKb());
+    }
+    for (const auto& lat : latency_) {
+      if (lat.layer != layer) continue;
+      const Histogram& h = lat.hist;
+      printf("%s latency over %" PRIu64 " updates: p50 %.3f us, p99 %.3f us, "
+             "p999 %.3f us, max %.3f us\n", lat.op.c_str(), h.count(),
+             h.Percentile(50) / 1e3, h.Percentile(99) / 1e3,
+             h.Percentile(99.9) / 1e3, h.Percentile(100) / 1e3);
+      for (const auto& slow : lat.slowest) {
+        printf("  %.3f us: %s\n", slow.first / 1e3, slow.second.c_str());
+      }
+    }
+  }
+  // the phases and the memory of a layer as the JSON fields "phases" and
+  // "memory"
+  std::string Json(const int64_t layer) const {
+    std::string out = "\"phases\": [";
+    char buf[256];
+    bool first = true;
+    for (const auto& p : phases_) {
+      if (p.layer != layer) continue;
+      snprintf(buf, sizeof buf,
+               "%s{\"name\": \"%s\", \"ms\": %.3f, \"rss_kb\": %" PRIu64
+               ", \"peak_kb\": %" PRIu64 "}", first ? "" : ", ",
+               p.name.c_str(), p.ms, p.rss_kb, p.peak_kb);
+      out += buf;
+      first = false;
+    }
+    out += "], \"memory\": {";
+    first = true;
+    for (const auto& lm : memory_) {
+      if (lm.first != layer) continue;
+      for (const auto& m : lm.second) {
+        snprintf(buf, sizeof buf, "%s\"%s\": %" PRIu64, first ? "" : ", ",
+                 m.first.c_str(), m.second);
+        out += buf;
+        first = false;
+      }
+    }
+    out += "}, \"latency\": {";
+    first = true;
+    for (const auto& lat : latency_) {
+      if (lat.layer != layer) continue;
+      out += (first ? "\"" : ", \"") + lat.op + "\": " + lat.hist.Json();
+      out.pop_back();
+      out += ", \"slowest\": [";
+      for (size_t i = 0; i < lat.slowest.size(); ++i) {
+        snprintf(buf, sizeof buf, "%s{\"ns\": %" PRIu64 ", \"update\": ",
+                 i > 0 ? ", " : "", lat.slowest[i].first);
+        out += buf + lat.slowest[i].second + "}";
+      }
+      out += "]}";
+      first = false;
+    }
+    return out + "}";
+  }
+
+ private:
+  struct LayerLatency final {
+    int64_t layer;
+    std::string op;
+    Histogram hist;
+    std::vector<std::pair<uint64_t, std::string>> slowest;
+  };
+  std::chrono::steady_clock::time_point last_;
+  std::vector<Phase> phases_;
+  std::vector<std::pair<int64_t, MemoryT>> memory_;
+  std::vector<LayerLatency> latency_;
+};
+
+}  // namespace truss_maint
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef TRUSS_MAINT_REORDER_H_
+#define TRUSS_MAINT_REORDER_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace truss_maint {
+// the vertex orders that cluster the edges of a vertex and of its
+// neighbors, so that the adjacency arrays and the per-edge arrays indexed
+// by edge ID are accessed with more locality: kDegree puts the vertices of
+// higher degree first, and kRcm is the reverse Cuthill-McKee order, a
+// breadth-first order from a vertex of least degree that keeps the
+// neighbors of a vertex close to it
+enum class Reorder { kOff, kDegree, kRcm };
+
+inline const char* ReorderName(const Reorder method) {
+  switch (method) {
+    case Reorder::kDegree: return "degree";
+    case Reorder::kRcm: return "rcm";
+    default: return "off";
+  }
+}
+// the order named by the environment variable TRUSS_REORDER, "off",
+// "degree" or "rcm"; off if it is not set or not known
+inline Reorder ReorderFromEnv() {
+  const char* env = std::getenv("TRUSS_REORDER");
+  if (nullptr == env) return Reorder::kOff;
+  for (const Reorder method : {Reorder::kDegree, Reorder::kRcm}) {
+    if (std::string(ReorderName(method)) == env) return method;
+  }
+  return Reorder::kOff;
+}
+
+// the rank of every vertex of a graph with @n vertices and the (directed)
+// edges @edges in the order @method, which ignores the directions;
+// rank[v] is the new ID of v, and all ranks are distinct
+template <typename VidT>
+std::vector<VidT> VertexRank(const VidT n,
+                             const std::vector<std::pair<VidT, VidT>>& edges,
+                             const Reorder method) {
+  std::vector<VidT> order(n);
+  std::iota(order.begin(), order.end(), VidT{0});
+  if (Reorder::kOff != method) {
+    std::vector<uint64_t> deg(n, 0);
+    for (const auto& edge : edges) {
+      ++deg[edge.first];
+      ++deg[edge.second];
+    }
+    if (Reorder::kDegree == method) {
+      std::stable_sort(order.begin(), order.end(),
+                       [&deg](const VidT u, const VidT v) {
+                         return deg[u] > deg[v];
+                       });
+    } else {
+      // the undirected adjacency in the CSR format; off[v] .. off[v + 1]
+      // are the neighbors of v, visited in increasing degree
+      std::vector<uint64_t> off(size_t{n} + 1, 0);
+      for (VidT v = 0; v < n; ++v) off[v + 1] = off[v] + deg[v];
+      std::vector<VidT> adj(off[n]);
+      std::vector<uint64_t> pos(off.begin(), off.end() - 1);
+      for (const auto& edge : edges) {
+        adj[pos[edge.first]++] = edge.second;
+        adj[pos[edge.second]++] = edge.first;
+      }
+      const auto by_degree = [&deg](const VidT u, const VidT v) {
+        return deg[u] < deg[v] || (deg[u] == deg[v] && u < v);
+      };
+      for (VidT v = 0; v < n; ++v) {
+        std::sort(adj.begin() + off[v], adj.begin() + off[v + 1], by_degree);
+      }
+      // every component is searched from its vertex of least degree
+      std::vector<VidT> starts(order);
+      std::sort(starts.begin(), starts.end(), by_degree);
+      std::vector<bool> seen(n, false);
+      size_t tail = 0;
+      for (const VidT s : starts) {
+        if (seen[s]) continue;
+        seen[s] = true;
+        order[tail++] = s;
+        for (size_t head = tail - 1; head < tail; ++head) {
+          const VidT u = order[head];
+          for (uint64_t i = off[u]; i < off[u + 1]; ++i) {
+            if (seen[adj[i]]) continue;
+            seen[adj[i]] = true;
+            order[tail++] = adj[i];
+          }
+        }
+      }
+      std::reverse(order.begin(), order.end());
+    }
+  }
+  std::vector<VidT> rank(n);
+  for (VidT i = 0; i < n; ++i) rank[order[i]] = i;
+  return rank;
+}
+
+}  // namespace truss_maint
+
+#endif
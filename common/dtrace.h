@@ -0,0 +1,150 @@
+#ifndef TRUSS_MAINT_TRACE_H_
+#define TRUSS_MAINT_TRACE_H_
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace truss_maint {
+// a timeline of the run in the trace event format of chrome://tracing and
+// Perfetto, recorded if the environment variable TRUSS_TRACE names the file
+// to write it to at exit; otherwise a TraceScope costs a branch.
+// Every thread records into a ring buffer of its own, which keeps its last
+// kRing events; the buffer of a finished thread is handed to the next new
+// thread, so the threads of successive ParallelFor calls share the rows of
+// the timeline instead of adding one row per call
+class Trace final {
+ public:
+  static const char* Path() {
+    static const char* path = std::getenv("TRUSS_TRACE");
+    return path;
+  }
+  static bool On() { return nullptr != Path(); }
+  // the time in ns since the first call
+  static uint64_t Now() {
+    static const auto epoch = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - epoch).count();
+  }
+  // give the calling thread its ring before its first event begins, so
+  // that the threads running at the same time record into distinct rings
+  static void Attach() { Local(); }
+  // record the event @name from @beg to @end, with the argument @key =
+  // @value if @key is not nullptr; @name and @key should be literals
+  static void Record(const char* name, const char* key, const int64_t value,
+                     const uint64_t beg, const uint64_t end) {
+    Ring& ring = Local();
+    Event& ev = ring.events[ring.next % kRing];
+    ev = {name, key, value, beg, end - beg};
+    ++ring.next;
+  }
+
+ private:
+  static constexpr size_t kRing = size_t{1} << 16;
+  struct Event final {
+    const char* name;
+    const char* key;
+    int64_t value;
+    uint64_t beg;
+    uint64_t dur;
+  };
+  struct Ring final {
+    uint32_t tid;
+    uint64_t next = 0;  // the # of events recorded
+    std::vector<Event> events = std::vector<Event>(kRing);
+  };
+  // the rings of all threads, written to the trace file at exit
+  struct Rings final {
+    std::mutex mu;
+    std::vector<std::unique_ptr<Ring>> all;
+    std::vector<Ring*> idle;
+    ~Rings() {
+      FILE* f = fopen(Path(), "w");
+      if (nullptr == f) return;
+      fprintf(f, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+      bool first = true;
+      for (const auto& ring : all) {
+        fprintf(f, "%s\n{\"name\": \"thread_name\", \"ph\": \"M\", "
+                "\"pid\": 1, \"tid\": %u, \"args\": {\"name\": \"thread %u%s"
+                "\"}}", first ? "" : ",", ring->tid, ring->tid,
+                ring->next > kRing ? " (oldest events dropped)" : "");
+        first = false;
+        const uint64_t beg = ring->next > kRing ? ring->next - kRing : 0;
+        for (uint64_t i = beg; i < ring->next; ++i) {
+          const Event& ev = ring->events[i % kRing];
+          fprintf(f, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, "
+                  "\"tid\": %u, \"ts\": %.3f, \"dur\": %.3f", ev.name,
+                  ring->tid, ev.beg / 1e3, ev.dur / 1e3);
+          if (nullptr != ev.key) {
+            fprintf(f, ", \"args\": {\"%s\": %" PRId64 "}", ev.key, ev.value);
+          }
+          fprintf(f, "}");
+        }
+      }
+      fprintf(f, "\n]}\n");
+      fclose(f);
+    }
+  };
+  static Rings& Global() {
+    static Rings rings;
+    return rings;
+  }
+  // the ring of the calling thread, returned to the idle ones at its exit
+  struct Holder final {
+    Ring* ring = nullptr;
+    ~Holder() {
+      if (nullptr == ring) return;
+      Rings& g = Global();
+      std::lock_guard<std::mutex> lock(g.mu);
+      g.idle.push_back(ring);
+    }
+  };
+  static Ring& Local() {
+    thread_local Holder holder;
+    if (nullptr == holder.ring) {
+      Rings& g = Global();
+      std::lock_guard<std::mutex> lock(g.mu);
+      if (g.idle.empty()) {
+        g.all.emplace_back(new Ring());
+        g.all.back()->tid = g.all.size();
+        holder.ring = g.all.back().get();
+      } else {
+        holder.ring = g.idle.back();
+        g.idle.pop_back();
+      }
+    }
+    return *holder.ring;
+  }
+};
+
+// record the lifetime of the scope as an event, if tracing
+class TraceScope final {
+ public:
+  explicit TraceScope(const char* name, const char* key = nullptr,
+                      const int64_t value = 0)
+      : name_(Trace::On() ? name : nullptr), key_(key), value_(value),
+        beg_(nullptr == name_ ? 0 : Trace::Now()) {
+    if (nullptr != name_) Trace::Attach();
+  }
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+  ~TraceScope() {
+    if (nullptr == name_) return;
+    Trace::Record(name_, key_, value_, beg_, Trace::Now());
+  }
+
+ private:
+  const char* name_;
+  const char* key_;
+  const int64_t value_;
+  const uint64_t beg_;
+};
+
+}  // namespace truss_maint
+
+#endif
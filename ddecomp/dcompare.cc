@@ -1,53 +1,132 @@
-#include <cassert>
+#include <cinttypes>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <fstream>
-#include <map>
-#include <tuple>
+#include <functional>
+#include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "ddecom.h"
+
 using std::uint32_t;
-using EdgeT = std::pair<uint32_t, uint32_t>;
-using InfoT = std::tuple<uint32_t, uint32_t, uint32_t>;
+using truss_maint::decomp::EidT;
+using truss_maint::decomp::VidT;
+using EdgeT = std::pair<VidT, VidT>;
+
+namespace {
+struct EdgeHash final {
+  size_t operator()(const EdgeT& e) const {
+    return std::hash<uint64_t>()(uint64_t{e.first} * 0x9e3779b97f4a7c15ULL ^
+                                 uint64_t{e.second});
+  }
+};
+// the trussness and the triangle support of an edge of the answer, and
+// whether a record of the result matched it
+struct Expected final {
+  uint32_t k;
+  uint32_t ts;
+  bool seen;
+};
+}  // namespace
 
-int main(int /* argc */, char** argv) {
-  std::map<EdgeT, InfoT> answer; {
+// compare the index argv[2] against the text answer argv[1], edge by
+// directed edge, so that an edge and its reverse are told apart; the answer
+// is kept in a hash table and the records of the index are streamed through
+// it. The first argv[3] (10 by default) mismatches are reported; the exit
+// status is 1 if there is any
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    fprintf(stderr, "usage: %s answer.txt result.idx [report]\n", argv[0]);
+    return 2;
+  }
+  const uint64_t report = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 10;
+  std::unordered_map<EdgeT, Expected, EdgeHash> answer; {
     std::ifstream afile(argv[1], std::ios::in);
     uint32_t n, m, l;
     afile >> n >> m >> l;
-    // space
+    // the edges and their truss numbers come first, then rem and ts
     std::vector<EdgeT> edges;
     std::vector<uint32_t> k(m);
-    std::vector<uint32_t> rem(m);
-    std::vector<uint32_t> ts(m);
-    // read edges and truss numbers
     for (uint32_t i = 0; i < m; ++i) {
-      uint32_t v1, v2;
+      VidT v1, v2;
       afile >> v1 >> v2 >> k[i];
-      if (v1 > v2) std::swap(v1, v2);
       edges.push_back({v1, v2});
     }
+    answer.reserve(m);
     for (uint32_t i = 0; i < m; ++i) {
-      afile >> rem[i] >> ts[i];
+      uint32_t rem, ts;
+      afile >> rem >> ts;
+      answer[edges[i]] = {k[i], ts, false};
     }
-    // create answer
-    for (uint32_t i = 0; i < m; ++i) {
-      answer[edges[i]] = {k[i], 0, ts[i]};
+    if (!afile) {
+      fprintf(stderr, "cannot read the answer %s\n", argv[1]);
+      return 2;
     }
-    afile.close();
   }
-  std::map<EdgeT, InfoT> result; {
+  uint64_t mismatches = 0;
+  const auto mismatch = [&mismatches, report](const std::string& what) {
+    if (mismatches++ < report) printf("  %s\n", what.c_str());
+  };
+  char buf[256];
+  {
     std::ifstream rfile(argv[2], std::ios::binary);
-    uint32_t n, m;
+    VidT n;
+    EidT m;
     rfile.read(reinterpret_cast<char*>(&n), sizeof n)
          .read(reinterpret_cast<char*>(&m), sizeof m);
-    for (uint32_t buf[5], i = 0; i < m; ++i) {
-      rfile.read(reinterpret_cast<char*>(buf), sizeof buf);
-      if (buf[0] > buf[1]) std::swap(buf[0], buf[1]);
-      result[std::make_pair(buf[0], buf[1])] = {buf[2], 0, buf[4]};
+    if (!rfile) {
+      fprintf(stderr, "cannot read the result %s\n", argv[2]);
+      return 2;
     }
-    rfile.close();
+    for (EidT rec[5], i = 0; i < m; ++i) {
+      if (!rfile.read(reinterpret_cast<char*>(rec), sizeof rec)) {
+        snprintf(buf, sizeof buf, "the result ends after %" PRIu64 " of %"
+                 PRIu64 " records", uint64_t{i}, uint64_t{m});
+        mismatch(buf);
+        break;
+      }
+      const EdgeT e(rec[0], rec[1]);
+      const auto it = answer.find(e);
+      if (answer.end() == it) {
+        snprintf(buf, sizeof buf, "record %" PRIu64 ": edge (%" PRIu64 ", %"
+                 PRIu64 ") not in the answer", uint64_t{i}, uint64_t{e.first},
+                 uint64_t{e.second});
+        mismatch(buf);
+      } else if (it->second.seen) {
+        snprintf(buf, sizeof buf, "record %" PRIu64 ": edge (%" PRIu64 ", %"
+                 PRIu64 ") repeated", uint64_t{i}, uint64_t{e.first},
+                 uint64_t{e.second});
+        mismatch(buf);
+      } else {
+        it->second.seen = true;
+        if (it->second.k != rec[2] || it->second.ts != rec[4]) {
+          snprintf(buf, sizeof buf, "record %" PRIu64 ": edge (%" PRIu64
+                   ", %" PRIu64 ") has k %" PRIu64 " and ts %" PRIu64
+                   ", expected %u and %u", uint64_t{i}, uint64_t{e.first},
+                   uint64_t{e.second}, uint64_t{rec[2]}, uint64_t{rec[4]},
+                   it->second.k, it->second.ts);
+          mismatch(buf);
+        }
+      }
+    }
+  }
+  for (const auto& a : answer) {
+    if (a.second.seen) continue;
+    snprintf(buf, sizeof buf, "edge (%" PRIu64 ", %" PRIu64 ") with k %u "
+             "missing from the result", uint64_t{a.first.first},
+             uint64_t{a.first.second}, a.second.k);
+    mismatch(buf);
+  }
+  if (0 == mismatches) {
+    printf("%zu edges match.\n", answer.size());
+    return 0;
+  }
+  if (mismatches > report) {
+    printf("  ... and %" PRIu64 " more\n", mismatches - report);
   }
-  // compare
-  assert(answer == result);
+  printf("%" PRIu64 " mismatches.\n", mismatches);
+  return 1;
 }
@@ -1,11 +1,15 @@
 #include "ddecom.h"
 #include <algorithm>
+#include <chrono>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <numeric>
+#include <string>
 #include <utility>
-#include <unordered_set>
+
+#include "dreorder.h"
+#include "dtrace.h"
 
 #define ASSERT(truth) \
     if (!(truth)) { \
@@ -31,6 +35,54 @@ namespace decomp {
 // for convenience
 using std::uint32_t;
 
+const char* CompactionName(const Compaction when) {
+  switch (when) {
+    case Compaction::kOff: return "off";
+    case Compaction::kOn: return "on";
+    default: return "auto";
+  }
+}
+Compaction CompactionFromEnv() {
+  const char* env = std::getenv("TRUSS_COMPACT");
+  if (nullptr == env) return Compaction::kAuto;
+  for (const Compaction when : {Compaction::kOff, Compaction::kOn}) {
+    if (std::string(CompactionName(when)) == env) return when;
+  }
+  return Compaction::kAuto;
+}
+
+EidT Decomp::GraphView::Count(const AdjT& adj) {
+  EidT edges = 0;
+  for (const auto& a : adj) edges += a.size();
+  return edges;
+}
+Decomp::GraphView::Csr Decomp::GraphView::Copy(const AdjT& adj,
+                                               const Csr& csr) const {
+  Csr copy;
+  copy.off.resize(size_t{n_} + 1, 0);
+  for (VidT v = 0; v < n_; ++v) {
+    const RangeT range = Range(adj, csr, v);
+    for (const ArrayEntry* p = range.first; p != range.second; ++p) {
+      if (qualify_[p->eid]) copy.ent.push_back(*p);
+    }
+    copy.off[v + 1] = copy.ent.size();
+  }
+  copy.ent.shrink_to_fit();
+  return copy;
+}
+void Decomp::GraphView::Compact() {
+  TraceScope trace("GraphView::Compact");
+  Csr in = Copy(adj_in_, in_);
+  Csr out = Copy(adj_out_, out_);
+  in_ = std::move(in);
+  out_ = std::move(out);
+  edges_ = out_.ent.size();
+}
+std::uint64_t Decomp::GraphView::Bytes() const {
+  using truss_maint::Bytes;
+  return Bytes(in_.off) + Bytes(in_.ent) + Bytes(out_.off) + Bytes(out_.ent);
+}
+
 // truss decomposition and the corresponding order
 Decomp::Decomp(const std::string& file_name) {
 
@@ -41,7 +93,7 @@ Decomp::Decomp(const std::string& file_name) {
   ASSERT_MSG(!infile.eof(), "invalid graph file");
   // read the edges
   while (true) {
-    uint32_t v1, v2;
+    VidT v1, v2;
     infile >> v1 >> v2;
     if (infile.eof()) break;
     edges_.push_back({v1, v2});
@@ -54,6 +106,19 @@ Decomp::Decomp(const std::string& file_name) {
     ASSERT_MSG(edge.first < n_ && edge.second < n_, "invalid vertex ID");
   }
 
+  // relabel the vertices as TRUSS_REORDER says, before the edge IDs are
+  // assigned in the sorted order of the edges; the outputs map them back
+  const Reorder reorder = ReorderFromEnv();
+  if (Reorder::kOff != reorder) {
+    const auto beg = std::chrono::steady_clock::now();
+    const std::vector<VidT> rank = VertexRank(n_, edges_, reorder);
+    orig_.resize(n_);
+    for (VidT v = 0; v < n_; ++v) orig_[rank[v]] = v;
+    for (auto& edge : edges_) edge = {rank[edge.first], rank[edge.second]};
+    prof_.Add("parse.reorder", -1, std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - beg).count());
+  }
+
   std::sort(edges_.begin(), edges_.end());
  
   ASSERT_MSG(std::unique(edges_.begin(), edges_.end()) == edges_.end(),
@@ -63,14 +128,14 @@ Decomp::Decomp(const std::string& file_name) {
   // initialize adjacency arrays
   adj_out.resize(n_);
   adj_in.resize(n_);
-  for (uint32_t eid = 0; eid < m_; ++eid) {
-    const uint32_t v1 = edges_[eid].first;
-    const uint32_t v2 = edges_[eid].second;
+  for (EidT eid = 0; eid < m_; ++eid) {
+    const VidT v1 = edges_[eid].first;
+    const VidT v2 = edges_[eid].second;
     adj_out[v1].push_back({v2, eid});
     adj_in[v2].push_back({v1, eid});
   }
 
-  for (uint32_t vid = 0; vid < n_; ++vid) {
+  for (VidT vid = 0; vid < n_; ++vid) {
     adj_out[vid].shrink_to_fit();
     adj_in[vid].shrink_to_fit();
     std::sort(adj_out[vid].begin(), adj_out[vid].end(),
@@ -85,46 +150,80 @@ Decomp::Decomp(const std::string& file_name) {
 
   
 
+  prof_.Mark("parse", -1);
   // D-truss decomposition
 
-  std::vector<uint32_t> verts(n_);
-  std::iota(verts.begin(), verts.end(), 0);
-  
+  // the layers are views of the adjacency arrays; layer i keeps the edges
+  // with flow support at least i
+  std::vector<bool> qualify(m_, true);
+  GraphView view(n_, adj_in, adj_out, qualify);
+  const Compaction compaction = CompactionFromEnv();
+
   uint32_t maxf= 0;
   fs_.resize(m_, 0); ford_.resize(m_); frem_.resize(m_, 0); fts_.resize(m_, 0);
-  flowDecomp(adj_in, adj_out, verts, fs_, frem_, fts_, ford_, maxf);
+  flowDecomp(view, fs_, frem_, fts_, ford_, maxf);
+  prof_.Mark("flow", -1);
+  prof_.Memory(-1, {{"adjacency", Bytes(adj_in) + Bytes(adj_out)},
+                    {"edges", Bytes(edges_)},
+                    {"flow", Bytes(fs_) + Bytes(frem_) + Bytes(fts_) +
+                             Bytes(ford_)}});
   
-  std::vector<bool> qualify(m_, true);
   D_.resize(maxf+1); Dord_.resize(maxf+1); Drem_.resize(maxf+1); Dts_.resize(maxf+1);
+  // the memory held after the layer i
+  const auto memory = [this, &qualify, &view](const uint32_t i) {
+    prof_.Memory(i, {{"adjacency", Bytes(adj_in) + Bytes(adj_out)},
+                     {"view", view.Bytes()},
+                     {"edges", Bytes(edges_)},
+                     {"layers", Bytes(D_) + Bytes(Drem_) + Bytes(Dts_) +
+                                Bytes(Dord_)},
+                     {"scratch", Bytes(cs_) + Bytes(crem_) + Bytes(cts_) +
+                                 Bytes(cord_) + Bytes(qualify)}});
+  };
   
 
   for(uint32_t i = 0; i <= maxf; i++){
+    TraceScope trace("layer", "layer", i);
 
-    for(uint32_t eid =0; eid< m_; eid++){
+    for(EidT eid =0; eid< m_; eid++){
       if(fs_[eid] < i) qualify[eid] = false;      
     }
+    const EidT qualified = std::count(qualify.begin(), qualify.end(), true);
+    // a layer of at most half of the edges viewed is worth its own arrays
+    if (Compaction::kOn == compaction ||
+        (Compaction::kAuto == compaction &&
+         2 * std::uint64_t{qualified} <= view.edges())) {
+      view.Compact();
+      prof_.Mark("compact", i);
+    }
+    stats_.emplace_back();
+    if (kStats) {
+      stats_.back().edges = qualified;
+      stats_.back().view_edges = view.edges();
+    }
 
     cs_.resize(m_, 0); cord_.resize(m_); crem_.resize(m_, 0); cts_.resize(m_, 0);
     
     // 1. count cycle supports
-    for (const uint32_t u : verts) {    
-      for (const auto ae : adj_out[u]) {
-        const uint32_t v = ae.vid;
-        const uint32_t e = ae.eid;
-        if(!qualify[e]) continue;
-        std::vector<uint32_t> W_;
-        W_ = intersectionQuali(adj_in[u], adj_out[v], qualify); 
-        cs_[e] += W_.size();
-      }
+    for (VidT u = 0; u < n_; ++u) {
+      view.ForOut(u, [this, u, &view](const VidT v, const EidT e) {
+        uint32_t w = 0;
+        view.ForCycles(u, v, [&w](const EidT, const EidT) { ++w; });
+        cs_[e] += w;
+        if (kStats) stats_.back().support_triangles += w;
+      });
     }
     uint32_t maxc = *max_element(cs_.cbegin(), cs_.cend());
+    prof_.Mark("support", i);
     if(!maxc){
       D_[i] = cs_; Drem_[i] = crem_; Dts_[i] = cts_; Dord_[i] = cord_;
+      memory(i);
       break;
     }
-    cycleDecomp(adj_in, adj_out, verts, cs_, crem_, cts_, cord_, qualify);
+    cycleDecomp(view, cs_, crem_, cts_, cord_, qualify);
     D_[i].resize(m_, 0); Dord_[i].resize(m_); Drem_[i].resize(m_, 0); Dts_[i].resize(m_, 0);
     D_[i] = cs_; Drem_[i] = crem_; Dts_[i] = cts_; Dord_[i] = cord_;
+    prof_.Mark("peel", i);
+    memory(i);
     cs_.clear(); cord_.clear(); crem_.clear(); cts_.clear();
     
   }
@@ -132,30 +231,28 @@ Decomp::Decomp(const std::string& file_name) {
   decltype(adj_out)().swap(adj_out);
 }
 
-void Decomp::cycleDecomp(std::vector<std::vector<Decomp::ArrayEntry>> adj_in,
-                        std::vector<std::vector<Decomp::ArrayEntry>> adj_out,
-                        std::vector<uint32_t> verts,
+void Decomp::cycleDecomp(const GraphView& view,
                         std::vector<std::uint32_t>& cs_,
                         std::vector<std::uint32_t>& crem_,
                         std::vector<std::uint32_t>& cts_,
-                        std::vector<std::uint32_t>& cord_,
+                        std::vector<EidT>& cord_,
                         std::vector<bool>& qualify){
-  
+  TraceScope trace("cycleDecomp");
 
   // 2. decomposition
   const uint32_t maxc = *max_element(cs_.cbegin(), cs_.cend()); 
-  std::vector<uint32_t> cbin(maxc + 1, 0);
+  std::vector<EidT> cbin(maxc + 1, 0);
   // 2.1. cycle decompose: build cbin and cord_, sort the edges according to their supports
-  for (uint32_t eid = 0; eid < m_; ++eid) {
+  for (EidT eid = 0; eid < m_; ++eid) {
     if(!qualify[eid]) continue;
     ++cbin[cs_[eid]];
   }
-  for (uint32_t i = 0, start = 0; i <= maxc; ++i) {
+  for (EidT i = 0, start = 0; i <= maxc; ++i) {
     start += cbin[i];
     cbin[i] = start - cbin[i];
   }
-  std::vector<uint32_t> cpos(m_);
-  for (uint32_t eid = 0; eid < m_; ++eid) {
+  std::vector<EidT> cpos(m_);
+  for (EidT eid = 0; eid < m_; ++eid) {
     if(!qualify[eid]) continue;
     cpos[eid] = cbin[cs_[eid]];
     cord_[cpos[eid]] = eid;
@@ -166,33 +263,39 @@ void Decomp::cycleDecomp(std::vector<std::vector<Decomp::ArrayEntry>> adj_in,
   // 2.2. cycle decompose: build crem_ and cts_ via peeling
   std::vector<bool> cremoved(m_, false);
   uint32_t c = 0;
- 
-  for (uint32_t i = 0; i < m_; ++i) { 
-    const uint32_t eid = cord_[i];
+  // the triangles of an edge, reused by all the edges
+  std::vector<std::pair<EidT, EidT>> ctris;
+
+  for (EidT i = 0; i < m_; ++i) { 
+    const EidT eid = cord_[i];
     if(!qualify[eid]) continue;
     c = std::max(c, cs_[cord_[i]]);
     ++cbin[cs_[eid]];
     cremoved[eid] = true;
     // find triangles containing the edge with ID eid
-    std::vector<std::pair<uint32_t, uint32_t>> ctris; {
-      const uint32_t v1 = edges_[eid].first;
-      const uint32_t v2 = edges_[eid].second;
-      ctris = intersecedgeQuali(adj_in[v1], adj_out[v2], qualify); 
+    ctris.clear();
+    view.ForCycles(edges_[eid].first, edges_[eid].second,
+                   [&ctris](const EidT e1, const EidT e2) {
+                     ctris.push_back({e1, e2});
+                   });
+    if (kStats) {
+      stats_.back().peel_triangles += ctris.size();
+      stats_.back().max_k = c;
     }
 
     for (const auto tri : ctris) {
-      const uint32_t e1 = tri.first;
-      const uint32_t e2 = tri.second;
+      const EidT e1 = tri.first;
+      const EidT e2 = tri.second;
       if(!qualify[e1] || !qualify[e2]) continue;
       if (cs_[e1] >= c && cs_[e2] >= c) ++cts_[eid];
       if (cremoved[e1] || cremoved[e2]) continue;
       ++crem_[eid];
-      for (const uint32_t e : {e1, e2}) {
+      for (const EidT e : {e1, e2}) {
         if (cs_[e] > c) {
-          const uint32_t pe3 = cbin[cs_[e]];
-          const uint32_t pe = cpos[e];
+          const EidT pe3 = cbin[cs_[e]];
+          const EidT pe = cpos[e];
           if (pe3 != pe) {
-            const uint32_t e3 = cord_[pe3];
+            const EidT e3 = cord_[pe3];
             cord_[pe] = e3;
             cpos[e3] = pe;
             cord_[pe3] = e;
@@ -200,6 +303,7 @@ void Decomp::cycleDecomp(std::vector<std::vector<Decomp::ArrayEntry>> adj_in,
           }
           ++cbin[cs_[e]]; 
           --cs_[e];
+          if (kStats) ++stats_.back().bin_moves;
         }
       }
     }
@@ -207,14 +311,15 @@ void Decomp::cycleDecomp(std::vector<std::vector<Decomp::ArrayEntry>> adj_in,
 }
 
 
-// similar to cycleDecomp
-void Decomp::flowDecomp(std::vector<std::vector<Decomp::ArrayEntry>> adj_in,
-                        std::vector<std::vector<Decomp::ArrayEntry>> adj_out,
-                        std::vector<uint32_t> verts,
+// similar to cycleDecomp; the flow decomposition is not implemented yet, so
+// the body is empty as it has been from the start, every flow support stays
+// 0 and maxf 0, and dsample writes the layer 0 only. It takes the view like
+// cycleDecomp does, instead of copies of the adjacency, but does not use it
+void Decomp::flowDecomp(const GraphView& view,
                         std::vector<std::uint32_t>& fs_,
                         std::vector<std::uint32_t>& frem_,
                         std::vector<std::uint32_t>& fts_,
-                        std::vector<std::uint32_t>& ford_,
+                        std::vector<EidT>& ford_,
                         std::uint32_t& maxf){
 
 }
@@ -228,8 +333,8 @@ void Decomp::DWriteToFile(const std::string& file_name) const {
 
   for (uint32_t i =0; i< Dord_.size(); i++) {
 
-    for (const uint32_t e : Dord_[i]){
-      const uint32_t buf[] = {edges_[e].first, edges_[e].second, D_[i][e], Drem_[i][e], Dts_[i][e]}; 
+    for (const EidT e : Dord_[i]){
+      const EidT buf[] = {Orig(edges_[e].first), Orig(edges_[e].second), D_[i][e], Drem_[i][e], Dts_[i][e]}; 
       outfile.write(reinterpret_cast<const char*>(buf), sizeof buf);
     }
     
@@ -237,116 +342,71 @@ void Decomp::DWriteToFile(const std::string& file_name) const {
   outfile.close();
 }
 
-std::vector<uint32_t> Decomp::intersection(std::vector<Decomp::ArrayEntry>& nums1, std::vector<Decomp::ArrayEntry>& nums2) {
-    if (nums1.empty() || nums2.empty()){
-        return std::vector<uint32_t>();
-    }
-    std::vector<uint32_t> a1, a2;
-    for(auto e: nums1){
-      a1.push_back(e.vid);
-    }
-    for(auto e: nums2){
-      a2.push_back(e.vid);
-    }
-    std::unordered_set<uint32_t> set{a1.cbegin(), a1.cend()};
-    std::vector<uint32_t> intersections;
-    for (auto n: a2){
-        if (set.erase(n) > 0){ // if n exists in set, then 1 is returned and n is erased; otherwise, 0.
-            intersections.push_back(n);
-        } 
+void Decomp::VWriteToFile(const std::string& file_name) const {
+  std::ofstream outfile(file_name, std::ios::binary);
+  const EidT layers = Layers();
+  outfile.write(reinterpret_cast<const char*>(&n_), sizeof n_)
+         .write(reinterpret_cast<const char*>(&layers), sizeof layers);
+  for (uint32_t i = 0; i < layers; i++) {
+    std::vector<EidT> vk(n_, ~EidT{0});
+    for (EidT e = 0; e < m_; ++e) {
+      for (const VidT v : {Orig(edges_[e].first), Orig(edges_[e].second)}) {
+        if (~EidT{0} == vk[v] || vk[v] < D_[i][e]) vk[v] = D_[i][e];
+      }
     }
-    return intersections;
+    outfile.write(reinterpret_cast<const char*>(vk.data()),
+                  vk.size() * sizeof(EidT));
+  }
+  outfile.close();
 }
 
-std::vector<uint32_t> Decomp::intersectionQuali(std::vector<Decomp::ArrayEntry>& nums1, std::vector<Decomp::ArrayEntry>& nums2, std::vector<bool>& qualify) {
-    if (nums1.empty() || nums2.empty()){
-        return std::vector<uint32_t>();
-    }
-    std::vector<uint32_t> a1, a2;
-    for(auto e: nums1){
-      if(qualify[e.eid]) a1.push_back(e.vid);
-    }
-    for(auto e: nums2){
-      if(qualify[e.eid]) a2.push_back(e.vid);
-    }
-    std::unordered_set<uint32_t> set{a1.cbegin(), a1.cend()};
-    std::vector<uint32_t> intersections;
-    for (auto n: a2){
-        if (set.erase(n) > 0){ // if n exists in set, then 1 is returned and n is erased; otherwise, 0.
-            intersections.push_back(n);
-        } 
+void Decomp::SWriteToFile(const std::string& file_name) const {
+  std::ofstream outfile(file_name, std::ios::binary);
+  const EidT layers = Layers();
+  outfile.write(reinterpret_cast<const char*>(&n_), sizeof n_)
+         .write(reinterpret_cast<const char*>(&m_), sizeof m_)
+         .write(reinterpret_cast<const char*>(&layers), sizeof layers);
+  std::vector<EidT> runs;
+  for (EidT e = 0; e < m_; ++e) {
+    // the trussness is non-increasing in the layer, so a run ends wherever
+    // it drops
+    runs.clear();
+    for (uint32_t i = 0; i < layers; i++) {
+      if (i + 1 == layers || D_[i + 1][e] != D_[i][e]) {
+        runs.push_back(i);
+        runs.push_back(D_[i][e]);
+      }
     }
-    return intersections;
+    const EidT buf[] = {Orig(edges_[e].first), Orig(edges_[e].second),
+                        static_cast<EidT>(runs.size() / 2)};
+    outfile.write(reinterpret_cast<const char*>(buf), sizeof buf)
+           .write(reinterpret_cast<const char*>(runs.data()),
+                  runs.size() * sizeof(EidT));
+  }
+  outfile.close();
 }
 
-std::vector<std::pair<uint32_t, uint32_t>> Decomp::intersecedge(std::vector<Decomp::ArrayEntry>& nums1, std::vector<Decomp::ArrayEntry>& nums2) {
-    
-    if (nums1.empty() || nums2.empty()){
-        return std::vector<std::pair<uint32_t, uint32_t>>();
-    }
-
-    std::vector<uint32_t> a1, a2;
-    for(auto e: nums1){
-      a1.push_back(e.vid);
-    }
-    for(auto e: nums2){
-      a2.push_back(e.vid);
-    }
-
-    std::unordered_set<uint32_t> set{a1.cbegin(), a1.cend()};
-    std::vector<std::pair<uint32_t, uint32_t>> intersecedges;
-    
-
-    for (auto n: a2){
-        if (set.erase(n) > 0){ // if n exists in set, then 1 is returned and n is erased; otherwise, 0.
-            std::pair<uint32_t, uint32_t> arr;
-            uint32_t ar1, ar2;
-            for(auto e: nums1){
-              if(n == e.vid) ar1 = e.eid;
-            }
-            for(auto e: nums2){
-              if(n == e.vid) ar2 = e.eid;
-            }
-            arr = std::make_pair(ar1, ar2);
-            intersecedges.push_back(arr);
-        } 
-    }
-    return intersecedges;
+uint32_t Decomp::Layers() const {
+  uint32_t layers = 0;
+  while (layers < Dord_.size() && !Dord_[layers].empty()) ++layers;
+  return layers;
 }
 
-std::vector<std::pair<uint32_t, uint32_t>> Decomp::intersecedgeQuali(std::vector<Decomp::ArrayEntry>& nums1, std::vector<Decomp::ArrayEntry>& nums2, std::vector<bool>& qualify) {
-    
-    if (nums1.empty() || nums2.empty()){
-        return std::vector<std::pair<uint32_t, uint32_t>>();
-    }
-
-    std::vector<uint32_t> a1, a2;
-    for(auto e: nums1){
-      if(qualify[e.eid]) a1.push_back(e.vid);
-    }
-    for(auto e: nums2){
-      if(qualify[e.eid]) a2.push_back(e.vid);
-    }
-
-    std::unordered_set<uint32_t> set{a1.cbegin(), a1.cend()};
-    std::vector<std::pair<uint32_t, uint32_t>> intersecedges;
-    
-
-    for (auto n: a2){
-        if (set.erase(n) > 0){ // if n exists in set, then 1 is returned and n is erased; otherwise, 0.
-            std::pair<uint32_t, uint32_t> arr;
-            uint32_t ar1, ar2;
-            for(auto e: nums1){
-              if(n == e.vid) ar1 = e.eid;
-            }
-            for(auto e: nums2){
-              if(n == e.vid) ar2 = e.eid;
-            }
-            arr = std::make_pair(ar1, ar2);
-            intersecedges.push_back(arr);
-        } 
-    }
-    return intersecedges;
+std::string Decomp::StatsJson(const uint32_t layer) const {
+  ASSERT(layer < stats_.size() && layer < Layers());
+  const LayerStats& st = stats_[layer];
+  EidT changed = 0;
+  if (kStats && layer > 0) {
+    for (EidT e = 0; e < m_; ++e) changed += D_[layer][e] != D_[layer - 1][e];
+  }
+  return std::string("{\"enabled\": ") + (kStats ? "true" : "false") +
+         ", \"edges\": " + std::to_string(st.edges) +
+         ", \"view_edges\": " + std::to_string(st.view_edges) +
+         ", \"support_triangles\": " + std::to_string(st.support_triangles) +
+         ", \"peel_triangles\": " + std::to_string(st.peel_triangles) +
+         ", \"bin_moves\": " + std::to_string(st.bin_moves) +
+         ", \"max_k\": " + std::to_string(st.max_k) +
+         ", \"changed\": " + std::to_string(changed) + "}";
 }
 
 
@@ -3,10 +3,38 @@
 
 #include <cstdint>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "dprof.h"
+
 namespace truss_maint {
 namespace decomp {
+// the widths of vertex and edge IDs; building with -DTRUSS_WIDE_IDS allows
+// graphs beyond 2^29 edges and 2^32 vertices; the index records are written
+// with the same width, so dsample and dm should be built alike
+#ifdef TRUSS_WIDE_IDS
+typedef std::uint64_t VidT;
+typedef std::uint64_t EidT;
+#else
+typedef std::uint32_t VidT;
+typedef std::uint32_t EidT;
+#endif
+// the counters are updated under "if (kStats)", so building with
+// -DTRUSS_NO_STATS (make NOSTATS=1) compiles them out and they stay zero
+#ifdef TRUSS_NO_STATS
+const bool kStats = false;
+#else
+const bool kStats = true;
+#endif
+// when the view of a layer is compacted into arrays of its own, as the
+// environment variable TRUSS_COMPACT says: "off" never, "on" at every layer,
+// and "auto", the default, whenever the qualified edges of the layer are at
+// most half of the edges of the arrays it is viewed through
+enum class Compaction { kOff, kOn, kAuto };
+const char* CompactionName(const Compaction when);
+Compaction CompactionFromEnv();
+
 // class Decomp is to truss-decompose a graph; as a byproduct,
 // it produces a truss-decomposition order
 
@@ -22,36 +50,132 @@ class Decomp final {
   void cWriteToFile(const std::string& file_name) const;
   void fWriteToFile(const std::string& file_name) const;
   void DWriteToFile(const std::string& file_name) const;
+  // write the per-vertex summary: the header n and the # of layers, then
+  // for each layer and each vertex the largest trussness of its edges, or
+  // ~0 for a vertex without edges
+  void VWriteToFile(const std::string& file_name) const;
+  // write the (k, l) skyline of every edge: the header n, m and the # of
+  // layers, then for each edge v1, v2, the # of its runs and the runs as
+  // (the last layer of the run, the trussness of its layers)
+  void SWriteToFile(const std::string& file_name) const;
+  // the # of decomposed layers; the layers past the first one without
+  // triangles are left empty
+  uint32_t Layers() const;
+  // the counters of the decomposition of a layer
+  struct LayerStats final {
+    EidT edges = 0;                       // the qualified edges
+    EidT view_edges = 0;                  // the edges of its view's arrays
+    std::uint64_t support_triangles = 0;  // enumerated to count the supports
+    std::uint64_t peel_triangles = 0;     // enumerated by the peeling
+    std::uint64_t bin_moves = 0;          // the edges moved to a lower bin
+    std::uint32_t max_k = 0;              // the largest trussness
+  };
+  // the counters of the layer @layer as a JSON object, with the # of edges
+  // whose trussness differs from that in the previous layer
+  std::string StatsJson(const uint32_t layer) const;
+  // the phases of the decomposition and the memory held after each layer;
+  // parsing the graph and the flow decomposition are phases of layer -1
+  Profile& profile() { return prof_; }
   // adjacency array entry type
   typedef struct final {
-    std::uint32_t vid;
-    std::uint32_t eid;
+    VidT vid;
+    EidT eid;
   } ArrayEntry;
-  std::vector<uint32_t> intersection(std::vector<Decomp::ArrayEntry>& nums1, std::vector<Decomp::ArrayEntry>& nums2);
-  std::vector<uint32_t> intersectionQuali(std::vector<Decomp::ArrayEntry>& nums1, std::vector<Decomp::ArrayEntry>& nums2, std::vector<bool>& qualify);
-  std::vector<std::pair<uint32_t, uint32_t>> intersecedge(std::vector<Decomp::ArrayEntry>& nums1, std::vector<Decomp::ArrayEntry>& nums2);
-  std::vector<std::pair<uint32_t, uint32_t>> intersecedgeQuali(std::vector<Decomp::ArrayEntry>& nums1, std::vector<Decomp::ArrayEntry>& nums2, std::vector<bool>& qualify);
-  void cycleDecomp(std::vector<std::vector<Decomp::ArrayEntry>> adj_in,
-                        std::vector<std::vector<Decomp::ArrayEntry>> adj_out,
-                        std::vector<uint32_t> verts,
+  typedef std::vector<std::vector<ArrayEntry>> AdjT;
+  // a layer of the graph: the edges of @qualify, seen through the sorted
+  // adjacency arrays of the whole graph without copying them. Compact
+  // copies the entries of the qualified edges into a CSR of their own, so
+  // that the layer is scanned in time proportional to its size; edges
+  // disqualified after that are still skipped through @qualify
+  class GraphView final {
+   public:
+    GraphView(const VidT n, const AdjT& adj_in, const AdjT& adj_out,
+              const std::vector<bool>& qualify)
+        : n_(n), adj_in_(adj_in), adj_out_(adj_out), qualify_(qualify),
+          edges_(Count(adj_out)) {}
+    GraphView(const GraphView&) = delete;
+    GraphView& operator=(const GraphView&) = delete;
+    // keep only the entries of the qualified edges, in arrays of their own
+    void Compact();
+    bool compact() const { return !out_.off.empty(); }
+    // the edges in the arrays viewed, qualified or not
+    EidT edges() const { return edges_; }
+    std::uint64_t Bytes() const;
+    // the qualified out-neighbors of u as f(vid, eid)
+    template <typename F>
+    void ForOut(const VidT u, const F& f) const {
+      const auto out = Out(u);
+      for (const ArrayEntry* p = out.first; p != out.second; ++p) {
+        if (qualify_[p->eid]) f(p->vid, p->eid);
+      }
+    }
+    // f(e1, e2) for the qualified edges e1 = (w, v1) and e2 = (v2, w) of
+    // every common vertex w, in increasing order of w, by merging the
+    // sorted in-neighbors of v1 and out-neighbors of v2
+    template <typename F>
+    void ForCycles(const VidT v1, const VidT v2, const F& f) const {
+      const auto in = In(v1);
+      const auto out = Out(v2);
+      const ArrayEntry* p1 = in.first;
+      const ArrayEntry* p2 = out.first;
+      while (p1 != in.second && p2 != out.second) {
+        if (!qualify_[p1->eid]) {
+          ++p1;
+        } else if (!qualify_[p2->eid]) {
+          ++p2;
+        } else if (p1->vid == p2->vid) {
+          f(p1->eid, p2->eid);
+          ++p1; ++p2;
+        } else if (p1->vid < p2->vid) {
+          ++p1;
+        } else {
+          ++p2;
+        }
+      }
+    }
+
+   private:
+    typedef std::pair<const ArrayEntry*, const ArrayEntry*> RangeT;
+    // the entries of v are ent[off[v]] .. ent[off[v + 1] - 1]
+    struct Csr final {
+      std::vector<EidT> off;
+      std::vector<ArrayEntry> ent;
+    };
+    static EidT Count(const AdjT& adj);
+    RangeT In(const VidT v) const { return Range(adj_in_, in_, v); }
+    RangeT Out(const VidT v) const { return Range(adj_out_, out_, v); }
+    RangeT Range(const AdjT& adj, const Csr& csr, const VidT v) const {
+      if (csr.off.empty()) {
+        return {adj[v].data(), adj[v].data() + adj[v].size()};
+      }
+      return {csr.ent.data() + csr.off[v], csr.ent.data() + csr.off[v + 1]};
+    }
+    // copy the qualified entries of the arrays viewed now
+    Csr Copy(const AdjT& adj, const Csr& csr) const;
+    const VidT n_;
+    const AdjT& adj_in_;
+    const AdjT& adj_out_;
+    const std::vector<bool>& qualify_;
+    EidT edges_;
+    Csr in_, out_;
+  };
+  void cycleDecomp(const GraphView& view,
                         std::vector<std::uint32_t>& cs_,
                         std::vector<std::uint32_t>& crem_,
                         std::vector<std::uint32_t>& cts_,
-                        std::vector<std::uint32_t>& cord_,
+                        std::vector<EidT>& cord_,
                         std::vector<bool>& qualify);
-  void flowDecomp(std::vector<std::vector<Decomp::ArrayEntry>> adj_in,
-                        std::vector<std::vector<Decomp::ArrayEntry>> adj_out,
-                        std::vector<uint32_t> verts,
+  void flowDecomp(const GraphView& view,
                         std::vector<std::uint32_t>& fs_,
                         std::vector<std::uint32_t>& frem_,
                         std::vector<std::uint32_t>& fts_,
-                        std::vector<std::uint32_t>& ford_,
+                        std::vector<EidT>& ford_,
                         std::uint32_t& maxf);                    
  private:
   
   // data members
-  std::uint32_t n_;  // the # of vertices
-  std::uint32_t m_;  // the # of edges
+  VidT n_;  // the # of vertices
+  EidT m_;  // the # of edges
   // the adjacency array representation
   std::vector<std::vector<ArrayEntry>> adj_;
   std::vector<std::vector<ArrayEntry>> adj_in;
@@ -74,14 +198,20 @@ class Decomp final {
   std::vector<std::uint32_t> fts_;
   std::vector<std::vector<std::uint32_t>> Dts_;
   // the edge peeling order
-  std::vector<std::uint32_t> ord_;
-  std::vector<std::uint32_t> cord_;
-  std::vector<std::uint32_t> ford_;
-  std::vector<std::vector<std::uint32_t>> Dord_;
+  std::vector<EidT> ord_;
+  std::vector<EidT> cord_;
+  std::vector<EidT> ford_;
+  std::vector<std::vector<EidT>> Dord_;
   // the set of edges
-  std::vector<std::pair<std::uint32_t, std::uint32_t>> edges_;
-  std::vector<std::pair<std::uint32_t, std::uint32_t>> edges_out;
-  std::vector<std::pair<std::uint32_t, std::uint32_t>> edges_in;
+  std::vector<std::pair<VidT, VidT>> edges_;
+  // the original ID of each vertex if relabeled by TRUSS_REORDER, or empty
+  std::vector<VidT> orig_;
+  VidT Orig(const VidT v) const { return orig_.empty() ? v : orig_[v]; }
+  std::vector<std::pair<VidT, VidT>> edges_out;
+  std::vector<std::pair<VidT, VidT>> edges_in;
+  // the counters of the decomposed layers
+  std::vector<LayerStats> stats_;
+  Profile prof_;
 };
 
 
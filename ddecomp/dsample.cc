@@ -1,6 +1,9 @@
 #include "ddecom.h"
 #include <chrono>
 #include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
 
 int main(int /* argc */, char** argv) {
   // read the graph and truss-decompose it
@@ -11,4 +14,23 @@ int main(int /* argc */, char** argv) {
   printf("Re-decomposing costs \x1b[1;31m%f\x1b[0m ms.\n",
          std::chrono::duration<double, std::milli>(dif).count());
   index.DWriteToFile(argv[2]);
+  index.VWriteToFile(std::string(argv[2]) + ".vtx");
+  index.SWriteToFile(std::string(argv[2]) + ".sky");
+  auto& prof = index.profile();
+  prof.Mark("write", -1);
+  for (uint32_t i = 0; i < index.Layers(); ++i) prof.Print(i);
+  prof.Print(-1);
+  // append the counters, the phases and the memory of every layer, and the
+  // phases before the layers, as JSON lines to $TRUSS_STATS
+  const char* stats_file = std::getenv("TRUSS_STATS");
+  if (nullptr != stats_file) {
+    std::ofstream out(stats_file, std::ios::app);
+    for (uint32_t i = 0; i < index.Layers(); ++i) {
+      out << "{\"tool\": \"dsample\", \"graph\": \"" << argv[1]
+          << "\", \"layer\": " << i << ", \"counters\": "
+          << index.StatsJson(i) << ", " << prof.Json(i) << "}\n";
+    }
+    out << "{\"tool\": \"dsample\", \"graph\": \"" << argv[1]
+        << "\", \"layer\": -1, " << prof.Json(-1) << "}\n";
+  }
 }
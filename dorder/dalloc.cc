@@ -0,0 +1,22 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "dstats.h"
+
+// the counting operator new, linked only into the binaries that report
+// their allocations, so that the others keep the allocator of the library;
+// the array forms of operator new and operator delete default to these
+void* operator new(const size_t size) {
+  truss_maint::allocation_count.fetch_add(1, std::memory_order_relaxed);
+  const size_t bytes = 0 == size ? 1 : size;
+  while (true) {
+    void* p = std::malloc(bytes);
+    if (nullptr != p) return p;
+    // as the default one does, retry after the new handler frees memory
+    const std::new_handler handler = std::get_new_handler();
+    if (nullptr == handler) throw std::bad_alloc();
+    handler();
+  }
+}
+void operator delete(void* p) noexcept { std::free(p); }
@@ -0,0 +1,153 @@
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "defs.h"
+#include "dgraph.h"
+#include "dorder.h"
+
+namespace {
+// counts the cache misses of this process in user space; the counter is
+// unavailable on machines (e.g., VMs) without hardware events
+class MissCounter final {
+ public:
+  MissCounter() {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof attr;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd_ = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+  }
+  ~MissCounter() { if (fd_ >= 0) close(fd_); }
+  bool ok() const { return fd_ >= 0; }
+  void Start() {
+    if (fd_ < 0) return;
+    ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+  }
+  uint64_t Stop() {
+    if (fd_ < 0) return 0;
+    ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+    uint64_t cnt = 0;
+    if (read(fd_, &cnt, sizeof cnt) != sizeof cnt) return 0;
+    return cnt;
+  }
+
+ private:
+  int fd_;
+};
+
+// the figure after @label in the lines of a saved db report, or a negative
+// value if the report lacks it (e.g., its cache misses were n/a)
+double Figure(const std::vector<std::string>& report,
+              const std::string& label) {
+  for (const auto& line : report) {
+    if (0 != line.compare(0, label.size(), label)) continue;
+    const char* beg = line.c_str() + label.size();
+    char* end = nullptr;
+    const double v = std::strtod(beg, &end);
+    return end == beg ? -1.0 : v;
+  }
+  return -1.0;
+}
+// print a figure of this run against the same one of the baseline
+void Compare(const char* name, const double base, const double cur) {
+  if (base < 0.0 || cur < 0.0) {
+    printf("vs baseline, %s: n/a\n", name);
+  } else {
+    printf("vs baseline, %s: %.3f -> %.3f (%+.1f%%)\n", name, base, cur,
+           base > 0.0 ? (cur - base) / base * 100.0 : 0.0);
+  }
+}
+}  // namespace
+
+// measure the cache misses and the time per processed triangle, and compare
+// them with a report saved from another build on the same index and updates
+int main(int argc, char** argv) {
+  ASSERT_MSG(4 == argc || 5 == argc,
+             "usage: db <INDEX_PATH> <UPDATE_EDGE_PATH> <OP> [BASELINE_REPORT]");
+  const std::string index_file = argv[1];
+  const std::string update_file = argv[2];
+  const std::string op = argv[3];
+  // read the header
+  std::ifstream infile(index_file, std::ios::binary);
+  truss_maint::VidT n = -1;
+  truss_maint::EidT m = -1;
+  infile.read(reinterpret_cast<char*>(&n), sizeof n)
+        .read(reinterpret_cast<char*>(&m), sizeof m);
+  infile.close();
+  // read the updates
+  std::vector<truss_maint::EdgT> edges;
+  std::ifstream inc_file(update_file);
+  truss_maint::EidT inc_m = 0; inc_file >> inc_m;
+  for (truss_maint::EidT e = 0; e < inc_m; ++e) {
+    truss_maint::VidT v1, v2;
+    inc_file >> v1 >> v2;
+    edges.push_back({v1, v2});
+  }
+  inc_file.close();
+  truss_maint::Order tm(n, m, index_file, 0);
+  MissCounter mc;
+  mc.Start();
+  const uint64_t allocs0 = truss_maint::Allocations();
+  const auto beg = std::chrono::steady_clock::now();
+  if (op == "uinsert") {
+    for (const auto edge : edges) tm.DiInsert({edge});
+  } else if (op == "binsert") {
+    tm.DiBatchInsert(edges);
+  } else if (op == "udelete") {
+    for (const auto edge : edges) tm.DiRemove(edge.first, edge.second);
+  } else {
+    ASSERT_MSG(op == "bdelete", "unknown operation");
+    tm.DiBatchRemove(edges);
+  }
+  const auto end = std::chrono::steady_clock::now();
+  const uint64_t allocs = truss_maint::Allocations() - allocs0;
+  const uint64_t misses = mc.Stop();
+  const double ns =
+      std::chrono::duration<double, std::nano>(end - beg).count();
+  const uint64_t tris = tm.tri_cnt();
+  const double ns_per_tri = tris ? ns / tris : 0.0;
+  const double misses_per_tri =
+      !mc.ok() ? -1.0 : tris ? static_cast<double>(misses) / tris : 0.0;
+  char head[128];
+  snprintf(head, sizeof head, "%s: %zu updates, %" PRIu64 " triangles",
+           op.c_str(), edges.size(), tris);
+  printf("%s\n", head);
+  printf("time per triangle: %.2f ns\n", ns_per_tri);
+  if (mc.ok()) {
+    printf("cache misses per triangle: %.3f\n", misses_per_tri);
+  } else {
+    printf("cache misses per triangle: n/a (no hardware counters)\n");
+  }
+  printf("allocations per update: %.2f\n",
+         edges.empty() ? 0.0 : static_cast<double>(allocs) / edges.size());
+  if (5 != argc) return 0;
+  // the baseline report is the stdout of db built from another revision
+  std::ifstream base_file(argv[4]);
+  ASSERT_MSG(base_file.is_open(), "cannot open the baseline report");
+  std::vector<std::string> base;
+  for (std::string line; std::getline(base_file, line);) base.push_back(line);
+  base_file.close();
+  // the per-triangle figures only compare if both runs did the same work
+  ASSERT_MSG(!base.empty() && base[0] == head,
+             "the baseline report is of other updates or triangles");
+  Compare("time per triangle (ns)", Figure(base, "time per triangle: "),
+          ns_per_tri);
+  Compare("cache misses per triangle",
+          Figure(base, "cache misses per triangle: "), misses_per_tri);
+}
@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "defs.h"
+#include "dgen.h"
+#include "dgraph.h"
+
+namespace {
+using truss_maint::EdgT;
+using truss_maint::EidT;
+using truss_maint::Rng;
+using truss_maint::VidT;
+
+// the graph file read by dsample: "n m", then one "v1 v2" per line
+void WriteGraph(const std::string& fn, const VidT n, std::vector<EdgT> edges) {
+  std::sort(edges.begin(), edges.end());
+  std::ofstream out(fn);
+  ASSERT_MSG(out.is_open(), "cannot create the graph file");
+  out << n << ' ' << edges.size() << '\n';
+  for (const auto& edge : edges) {
+    out << edge.first << ' ' << edge.second << '\n';
+  }
+  out.close();
+  ASSERT_MSG(!out.fail(), "cannot write the graph file");
+}
+std::vector<EdgT> ReadGraph(const std::string& fn, VidT& n) {
+  std::ifstream in(fn);
+  ASSERT_MSG(in.is_open(), "cannot open the graph file");
+  EidT m = 0;
+  in >> n >> m;
+  std::vector<EdgT> edges(m);
+  for (auto& edge : edges) in >> edge.first >> edge.second;
+  ASSERT_MSG(!in.fail(), "invalid graph file");
+  return edges;
+}
+
+// the # of edges whose reverse is an edge too, and the # of cycle
+// triangles u -> v -> w -> u
+void Stats(const VidT n, const std::vector<EdgT>& edges, uint64_t& recip,
+           uint64_t& cycles) {
+  std::vector<std::vector<VidT>> in(n), out(n);
+  for (const auto& edge : edges) {
+    out[edge.first].push_back(edge.second);
+    in[edge.second].push_back(edge.first);
+  }
+  for (VidT v = 0; v < n; ++v) {
+    std::sort(in[v].begin(), in[v].end());
+    std::sort(out[v].begin(), out[v].end());
+  }
+  recip = cycles = 0;
+  for (const auto& edge : edges) {
+    const VidT u = edge.first, v = edge.second;
+    recip += std::binary_search(out[v].begin(), out[v].end(), u);
+    // the w with v -> w and w -> u
+    size_t p1 = 0, p2 = 0;
+    while (p1 < out[v].size() && p2 < in[u].size()) {
+      if (out[v][p1] == in[u][p2]) {
+        ++cycles; ++p1; ++p2;
+      } else if (out[v][p1] < in[u][p2]) {
+        ++p1;
+      } else {
+        ++p2;
+      }
+    }
+  }
+  // each cycle triangle is found from each of its three edges
+  cycles /= 3;
+}
+
+void Usage() {
+  fprintf(stderr,
+          "usage: dg graph <SCALE> <EDGES> <RECIPROCITY> <CYCLES> <SEED> "
+          "<GRAPH_PATH>\n"
+          "       dg updates <GRAPH_PATH> <insert|delete|mixed> <COUNT> "
+          "<SEED> <PREFIX>\n");
+  exit(1);
+}
+}  // namespace
+
+// generate graphs and update streams for the benchmarks
+int main(int argc, char** argv) {
+  if (argc < 2) Usage();
+  const std::string cmd = argv[1];
+  if ("graph" == cmd) {
+    // a directed R-MAT graph with 2^SCALE vertices and EDGES edges
+    if (8 != argc) Usage();
+    truss_maint::GenParams p;
+    p.scale = atoi(argv[2]);
+    p.m = strtoull(argv[3], nullptr, 10);
+    p.reciprocity = atof(argv[4]);
+    p.cycles = atof(argv[5]);
+    ASSERT_MSG(0 <= p.reciprocity && p.reciprocity <= 1 &&
+               0 <= p.cycles && p.cycles < 1, "invalid probability");
+    Rng rng(strtoull(argv[6], nullptr, 10));
+    const VidT n = VidT{1} << p.scale;
+    const auto edges = truss_maint::Generate(p, rng);
+    WriteGraph(argv[7], n, edges);
+    uint64_t recip = 0, cycles = 0;
+    Stats(n, edges, recip, cycles);
+    printf("%" PRIu64 " vertices, %zu edges, %" PRIu64 " reciprocal edges, "
+           "%" PRIu64 " cycle triangles\n", uint64_t{n}, edges.size(), recip,
+           cycles);
+    return 0;
+  }
+  // an update stream of COUNT edges sampled from the graph, with the graphs
+  // before (<PREFIX>.base) and after it (<PREFIX>.final); the stream is
+  // <PREFIX>.upd in the format of dm: "v1 v2" lines for insert and delete,
+  // and "+ v1 v2" or "- v1 v2" lines for mixed, which inserts half of the
+  // sampled edges and deletes the other half
+  if ("updates" != cmd || 7 != argc) Usage();
+  VidT n = 0;
+  std::vector<EdgT> edges = ReadGraph(argv[2], n);
+  const std::string kind = argv[3];
+  ASSERT_MSG("insert" == kind || "delete" == kind || "mixed" == kind,
+             "unknown kind of updates");
+  const EidT count = strtoull(argv[4], nullptr, 10);
+  ASSERT_MSG(count <= edges.size(), "more updates than edges");
+  Rng rng(strtoull(argv[5], nullptr, 10));
+  const std::string prefix = argv[6];
+  // the sampled edges come first
+  std::sort(edges.begin(), edges.end());
+  truss_maint::Shuffle(edges, rng);
+  const EidT nins = "insert" == kind ? count :
+                    "mixed" == kind ? count / 2 : 0;
+  // the inserted edges are absent from the base graph, and the deleted ones
+  // from the final graph
+  WriteGraph(prefix + ".base",
+             n, std::vector<EdgT>(edges.begin() + nins, edges.end()));
+  std::vector<EdgT> final_edges(edges.begin(), edges.begin() + nins);
+  final_edges.insert(final_edges.end(), edges.begin() + count, edges.end());
+  WriteGraph(prefix + ".final", n, final_edges);
+  std::ofstream out(prefix + ".upd");
+  ASSERT_MSG(out.is_open(), "cannot create the update file");
+  // the insertions and the deletions of a mixed stream are interleaved
+  std::vector<std::pair<EdgT, bool>> updates;
+  for (EidT i = 0; i < count; ++i) updates.push_back({edges[i], i < nins});
+  truss_maint::Shuffle(updates, rng);
+  out << count << '\n';
+  for (const auto& upd : updates) {
+    if ("mixed" == kind) out << (upd.second ? "+ " : "- ");
+    out << upd.first.first << ' ' << upd.first.second << '\n';
+  }
+  out.close();
+  ASSERT_MSG(!out.fail(), "cannot write the update file");
+  return 0;
+}
@@ -0,0 +1,87 @@
+#ifndef TRUSS_MAINT_GEN_H_
+#define TRUSS_MAINT_GEN_H_
+
+#include <cstdint>
+#include <random>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "dgraph.h"
+
+namespace truss_maint {
+// the synthetic inputs are drawn from the raw output of a seeded
+// mt19937_64, whose sequence is fixed by the standard unlike that of the
+// distributions, so a seed gives the same inputs on every build
+typedef std::mt19937_64 Rng;
+inline uint64_t Below(Rng& rng, const uint64_t n) { return rng() % n; }
+inline double Unit(Rng& rng) { return (rng() >> 11) / 9007199254740992.0; }
+template <typename T>
+void Shuffle(std::vector<T>& v, Rng& rng) {
+  for (size_t i = v.size(); i > 1; --i) std::swap(v[i - 1], v[Below(rng, i)]);
+}
+
+// a directed power-law graph: R-MAT edges over 2^scale vertices, with the
+// quadrant probabilities a, b, c and 1 - a - b - c
+struct GenParams final {
+  int scale;
+  EidT m;                    // the # of distinct edges
+  double a = 0.57;
+  double b = 0.19;
+  double c = 0.19;
+  double reciprocity = 0;    // the probability that (v, u) follows (u, v)
+  double cycles = 0;         // the fraction of edges drawn to close a 2-path
+};
+
+// the edges of the graph, without self-loops or duplicates, in the order
+// they are drawn; an edge closing a 2-path u -> v -> w is (w, u), which
+// forms the cycle triangle u -> v -> w -> u
+inline std::vector<EdgT> Generate(const GenParams& p, Rng& rng) {
+  ASSERT_MSG(0 < p.scale && p.scale < 32, "invalid scale");
+  ASSERT_MSG(p.m <= (uint64_t{1} << p.scale) * ((uint64_t{1} << p.scale) - 1),
+             "too many edges for the # of vertices");
+  std::unordered_set<uint64_t> seen;
+  std::vector<EdgT> edges;
+  // the out-neighbors, only needed to close 2-paths
+  std::vector<std::vector<VidT>> out(p.cycles > 0 ? VidT{1} << p.scale : 0);
+  const auto add = [&](const VidT v1, const VidT v2) {
+    if (v1 == v2 || edges.size() == p.m) return false;
+    if (!seen.insert(static_cast<uint64_t>(v1) << 32 | v2).second) {
+      return false;
+    }
+    edges.push_back({v1, v2});
+    if (!out.empty()) out[v1].push_back(v2);
+    return true;
+  };
+  while (edges.size() < p.m) {
+    // close a random 2-path; a path back to its start is retried as an
+    // R-MAT edge
+    if (p.cycles > 0 && !edges.empty() && Unit(rng) < p.cycles) {
+      const EdgT uv = edges[Below(rng, edges.size())];
+      const auto& ws = out[uv.second];
+      if (!ws.empty() && add(ws[Below(rng, ws.size())], uv.first)) continue;
+    }
+    VidT v1 = 0, v2 = 0;
+    for (int i = 0; i < p.scale; ++i) {
+      const double r = Unit(rng);
+      v1 = v1 << 1 | (r >= p.a + p.b);
+      v2 = v2 << 1 | ((r >= p.a && r < p.a + p.b) || r >= p.a + p.b + p.c);
+    }
+    if (add(v1, v2) && p.reciprocity > 0 && Unit(rng) < p.reciprocity) {
+      add(v2, v1);
+    }
+  }
+  return edges;
+}
+
+// the R-MAT graph with the default probabilities
+inline std::vector<EdgT> RMat(const int scale, const EidT m, Rng& rng) {
+  GenParams p;
+  p.scale = scale;
+  p.m = m;
+  return Generate(p, rng);
+}
+
+}  // namespace truss_maint
+
+#endif
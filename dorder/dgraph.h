@@ -6,31 +6,58 @@
 #include <numeric>
 #include <utility>
 #include <vector>
-#include <unordered_set>
 
 #include "defs.h"
+#include "dsnap.h"
+#include "dprof.h"
+#include "dstats.h"
 
 namespace truss_maint {
 using std::int32_t;
 using std::uint32_t;
+using std::uint64_t;
+
+// the widths of vertex and edge IDs; building with -DTRUSS_WIDE_IDS allows
+// graphs beyond 2^29 edges and 2^32 vertices at the cost of larger records
+#ifdef TRUSS_WIDE_IDS
+typedef uint64_t VidT;
+typedef uint64_t EidT;
+#else
+typedef uint32_t VidT;
+typedef uint32_t EidT;
+#endif
+static_assert(sizeof(VidT) == sizeof(EidT), "kNil is shared by both IDs");
+// the nil vertex or edge ID
+const EidT kNil = ~EidT{0};
+// IDs are required to be less than 2^kIdBits by the order maintenance
+const int kIdBits = 4 == sizeof(EidT) ? 29 : 61;
 // edge type
-typedef std::pair<uint32_t, uint32_t> EdgT;
+typedef std::pair<VidT, VidT> EdgT;
 
 typedef struct final {
-    uint32_t vid;
-    uint32_t eid;
+    VidT vid;
+    EidT eid;
   } ArrayEntry;
 
+// resize v to exactly n entries; unlike a plain resize, it neither
+// over-allocates when growing nor keeps the old buffer when shrinking
+template <typename T>
+void Fit(std::vector<T>& v, const size_t n, const T& val = T()) {
+  if (n > v.capacity()) v.reserve(n);
+  v.resize(n, val);
+  if (v.capacity() > n) v.shrink_to_fit();
+}
+
 // graph class
 class Graph final {
  public:
   
   // construct a graph with only n isolated vertices
-  Graph(const uint32_t n, const uint32_t l, const std::vector<int32_t>& k)
-      : l_(l), n_(n), m_(0), k_(k) {
-    ASSERT_MSG(0 < n_ && n_ < (static_cast<uint32_t>(1) << 29),
+  Graph(const VidT n, const EidT l)
+      : l_(l), n_(n), m_(0), wedges_(0) {
+    ASSERT_MSG(0 < n_ && n_ < (VidT{1} << kIdBits),
                "invalid argument");
-    ASSERT_MSG(0 < l_ && l_ < (static_cast<uint32_t>(1) << 29),
+    ASSERT_MSG(0 < l_ && l_ < (EidT{1} << kIdBits),
                "invalid argument");
     // available edges
     free_edges_.resize(l_);
@@ -41,36 +68,70 @@ class Graph final {
     adj_in.resize(n_);
     adj_out.resize(n_);
     // edge information
-    edge_info_.resize(l_, {UINT32_MAX, UINT32_MAX});
+    edge_info_.resize(l_, {kNil, kNil});
+  }
+  // restore a graph saved by Save; the adjacency arrays are read as they
+  // are, without sorting
+  explicit Graph(SnapReader& snap)
+      : l_(snap.Get<EidT>()), n_(snap.Get<VidT>()), m_(snap.Get<EidT>()),
+        wedges_(snap.Get<uint64_t>()) {
+    snap.GetVec(free_edges_);
+    snap.GetVec(edge_info_);
+    snap.GetNested(adj_in);
+    snap.GetNested(adj_out);
+    ASSERT_MSG(l_ == edge_info_.size() && n_ == adj_in.size() &&
+               n_ == adj_out.size(), "corrupted snapshot");
+    adj_.resize(n_);
+    // free_ is implied by the endpoints
+    free_.resize(l_);
+    for (EidT eid = 0; eid < l_; ++eid) free_[eid] = !Contain(eid);
   }
   ~Graph() {}
+  // save the graph, including the order in which the free IDs are reused
+  void Save(SnapWriter& snap) const {
+    snap.Put(l_);
+    snap.Put(n_);
+    snap.Put(m_);
+    snap.Put(wedges_);
+    snap.PutVec(free_edges_);
+    snap.PutVec(edge_info_);
+    snap.PutNested(adj_in);
+    snap.PutNested(adj_out);
+  }
 
 
 
 
   // get the endpoints of the edge with ID eid
-  inline EdgT Get(const uint32_t eid) const {
-    ASSERT_MSG(UINT32_MAX != edge_info_.at(eid).first, "invalid edge ID");
+  inline EdgT Get(const EidT eid) const {
+    ASSERT_MSG(kNil != edge_info_.at(eid).first, "invalid edge ID");
     return edge_info_[eid];
   }
 
   // get the ID of the edge with endpoints v1 and v2
-  uint32_t Get(uint32_t v1, uint32_t v2) const {
-    for (const auto ae : adj_out[v1]) {
-      if (ae.vid == v2) return ae.eid;
-    }
-    ASSERT(false);
-    return UINT32_MAX;
+  EidT Get(VidT v1, VidT v2) const {
+    const EidT eid = Find(v1, v2);
+    ASSERT(kNil != eid);
+    return eid;
+  }
+  // same as Get, but returns kNil if there is no edge (v1, v2);
+  // a binary search, as the adjacency arrays are sorted
+  EidT Find(VidT v1, VidT v2) const {
+    if (v1 >= n_ || v2 >= n_) return kNil;
+    const auto it = std::lower_bound(
+        adj_out[v1].begin(), adj_out[v1].end(), v2,
+        [](const ArrayEntry& ae, const VidT v) { return ae.vid < v; });
+    return adj_out[v1].end() != it && it->vid == v2 ? it->eid : kNil;
   }
 
   // get the triangles containing the edge with ID eid
-  std::vector<std::pair<uint32_t, uint32_t>>
-  GetTriangles(const uint32_t eid) const {
-    ASSERT_MSG(UINT32_MAX != edge_info_.at(eid).first, "invalid edge ID");
-    const uint32_t v1 = edge_info_[eid].first;
-    const uint32_t v2 = edge_info_[eid].second;
+  std::vector<std::pair<EidT, EidT>>
+  GetTriangles(const EidT eid) const {
+    ASSERT_MSG(kNil != edge_info_.at(eid).first, "invalid edge ID");
+    const VidT v1 = edge_info_[eid].first;
+    const VidT v2 = edge_info_[eid].second;
     ASSERT(v1 < n_ && v2 < n_);
-    std::vector<std::pair<uint32_t, uint32_t>> triangles;
+    std::vector<std::pair<EidT, EidT>> triangles;
     // find common neighbors
     size_t p1 = 0, p2 = 0;
     while (p1 < adj_[v1].size() && p2 < adj_[v2].size()) {
@@ -85,20 +146,22 @@ class Graph final {
     }
     return triangles;
   }
-  // get the triangles which contain the edge with ID eid
-  std::vector<std::pair<uint32_t, uint32_t>>
-  GetTriangles(const uint32_t eid, const int32_t k) const {
-    ASSERT_MSG(UINT32_MAX != edge_info_[eid].first, "invalid edge ID");
-    const uint32_t v1 = edge_info_[eid].first;
-    const uint32_t v2 = edge_info_[eid].second;
+  // get the triangles which contain the edge with ID eid;
+  // kof(e) returns the truss number of the edge with ID e
+  template <typename KFn>
+  std::vector<std::pair<EidT, EidT>>
+  GetTriangles(const EidT eid, const int32_t k, const KFn& kof) const {
+    ASSERT_MSG(kNil != edge_info_[eid].first, "invalid edge ID");
+    const VidT v1 = edge_info_[eid].first;
+    const VidT v2 = edge_info_[eid].second;
     ASSERT(v1 < n_ && v2 < n_);
-    std::vector<std::pair<uint32_t, uint32_t>> triangles;
+    std::vector<std::pair<EidT, EidT>> triangles;
     // find common neighbors
     size_t p1 = 0, p2 = 0;
     while (p1 < adj_[v1].size() && p2 < adj_[v2].size()) {
       if (adj_[v1][p1].vid == adj_[v2][p2].vid) {
         // the truss numbers of the other two edges should be at least k
-        if (k_[adj_[v1][p1].eid] >= k && k_[adj_[v2][p2].eid] >= k) {
+        if (kof(adj_[v1][p1].eid) >= k && kof(adj_[v2][p2].eid) >= k) {
           triangles.push_back({adj_[v1][p1].eid, adj_[v2][p2].eid});
         }
         ++p1; ++p2;
@@ -114,56 +177,51 @@ class Graph final {
 
 
   // Counting cycles: two overloads, with or without k
-  std::vector<std::pair<uint32_t, uint32_t>> 
-  GetCycles(const uint32_t eid) const {
-    ASSERT_MSG(UINT32_MAX != edge_info_.at(eid).first, "invalid edge ID");
-    const uint32_t v1 = edge_info_[eid].first;
-    const uint32_t v2 = edge_info_[eid].second;
+  // the triangles containing the edge (v1, v2) with ID eid, as the IDs of
+  // (w, v1) and (v2, w) for the common vertices w of adj_in[v1] and
+  // adj_out[v2] in increasing order; the arrays are sorted, so they are
+  // merged into @cycles, which is cleared first and keeps its capacity
+  void GetCycles(const EidT eid,
+                 std::vector<std::pair<EidT, EidT>>& cycles) const {
+    ASSERT_MSG(kNil != edge_info_.at(eid).first, "invalid edge ID");
+    const VidT v1 = edge_info_[eid].first;
+    const VidT v2 = edge_info_[eid].second;
     ASSERT(v1 < n_ && v2 < n_);
-
-    if (adj_in[v1].empty() || adj_out[v2].empty()){
-        return std::vector<std::pair<uint32_t, uint32_t>>();
-    }
-    std::vector<uint32_t> a1, a2;
-    for(auto e: adj_in[v1]){
-      a1.push_back(e.vid);
-    }
-    for(auto e: adj_out[v2]){
-      a2.push_back(e.vid);
-    }
-    std::unordered_set<uint32_t> set{a1.cbegin(), a1.cend()};
-    std::vector<std::pair<uint32_t, uint32_t>> triangles;
-
-    for (auto n: a2){
-        if (set.erase(n) > 0){ // if n exists in set, then 1 is returned and n is erased; otherwise, 0.
-            std::pair<uint32_t, uint32_t> arr;
-            uint32_t ar1, ar2;
-            for(auto e: adj_in[v1]){
-              if(n == e.vid) ar1 = e.eid;
-            }
-            for(auto e: adj_out[v2]){
-              if(n == e.vid) ar2 = e.eid;
-            }
-            arr = std::make_pair(ar1, ar2);
-            triangles.push_back(arr);
-        } 
+    cycles.clear();
+    const auto& in = adj_in[v1];
+    const auto& out = adj_out[v2];
+    size_t p1 = 0, p2 = 0;
+    while (p1 < in.size() && p2 < out.size()) {
+      if (in[p1].vid == out[p2].vid) {
+        cycles.push_back({in[p1].eid, out[p2].eid});
+        ++p1; ++p2;
+      } else if (in[p1].vid < out[p2].vid) {
+        ++p1;
+      } else {
+        ++p2;
+      }
     }
-    return triangles;
+  }
+  std::vector<std::pair<EidT, EidT>> GetCycles(const EidT eid) const {
+    std::vector<std::pair<EidT, EidT>> cycles;
+    GetCycles(eid, cycles);
+    return cycles;
   }
 
   // Counting flows: two overloads, with or without k
 
-  std::vector<std::pair<uint32_t, uint32_t>>
-  GetFlows(const uint32_t eid, const int32_t k) const {
-    ASSERT_MSG(UINT32_MAX != edge_info_[eid].first, "invalid edge ID");
-    const uint32_t v1 = edge_info_[eid].first;
-    const uint32_t v2 = edge_info_[eid].second;
+  template <typename KFn>
+  std::vector<std::pair<EidT, EidT>>
+  GetFlows(const EidT eid, const int32_t k, const KFn& kof) const {
+    ASSERT_MSG(kNil != edge_info_[eid].first, "invalid edge ID");
+    const VidT v1 = edge_info_[eid].first;
+    const VidT v2 = edge_info_[eid].second;
     ASSERT(v1 < n_ && v2 < n_);
-    std::vector<std::pair<uint32_t, uint32_t>> triangles;
+    std::vector<std::pair<EidT, EidT>> triangles;
     
     // guarantee that counting # of vertices instead of triangles
     std::vector<bool> v_in_flow;
-    for(int i =0; i< n_;i++){
+    for (VidT i = 0; i < n_; ++i){
       v_in_flow.push_back(false);
     }
     // find common neighbors for flow triangles
@@ -173,9 +231,9 @@ class Graph final {
     while(p1 < adj_in[v1].size() && p2 < adj_in[v2].size()){
       if(adj_in[v1][p1].vid == adj_in[v2][p2].vid){
         if(!v_in_flow[adj_in[v2][p2].vid] 
-          && k_[adj_in[v1][p1].eid] >= k 
-          && k_[adj_in[v2][p2].eid] >= k) {
-          triangles.push_back({adj_in[p1][v1].eid, adj_in[v2][p2].eid});
+          && kof(adj_in[v1][p1].eid) >= k 
+          && kof(adj_in[v2][p2].eid) >= k) {
+          triangles.push_back({adj_in[v1][p1].eid, adj_in[v2][p2].eid});
           v_in_flow[adj_in[v2][p2].vid] = true;
         }
         ++p1; ++p2;
@@ -191,9 +249,9 @@ class Graph final {
     while(p1 < adj_out[v1].size() && p2 < adj_out[v2].size()){
       if(adj_out[v1][p1].vid == adj_out[v2][p2].vid){
         if(!v_in_flow[adj_out[v2][p2].vid]
-          && k_[adj_out[v1][p1].eid] >= k
-          && k_[adj_out[v2][p2].eid] >= k){
-          triangles.push_back({adj_out[p1][v1].eid, adj_out[v2][p2].eid});
+          && kof(adj_out[v1][p1].eid) >= k
+          && kof(adj_out[v2][p2].eid) >= k){
+          triangles.push_back({adj_out[v1][p1].eid, adj_out[v2][p2].eid});
           v_in_flow[adj_out[v2][p2].vid] = true;
         }
         ++p1; ++p2;
@@ -209,9 +267,9 @@ class Graph final {
     while(p1 < adj_out[v1].size() && p2 < adj_in[v2].size()){
       if(adj_out[v1][p1].vid == adj_in[v2][p2].vid){
           if(!v_in_flow[adj_in[v2][p2].vid]
-            && k_[adj_out[v1][p1].eid] >= k 
-            && k_[adj_in[v2][p2].eid] >= k) {
-            triangles.push_back({adj_out[p1][v1].eid, adj_in[v2][p2].eid});
+            && kof(adj_out[v1][p1].eid) >= k 
+            && kof(adj_in[v2][p2].eid) >= k) {
+            triangles.push_back({adj_out[v1][p1].eid, adj_in[v2][p2].eid});
             v_in_flow[adj_in[v2][p2].vid] = true;
           }
           ++p1; ++p2;
@@ -225,20 +283,44 @@ class Graph final {
     return triangles;
 
   }
+  // the # of flow triangles that the edge (v1, v2) closes, whether or not it
+  // exists, counted as the flow supports of mainFlow are: the common vertices
+  // of the in-neighbors, of the out-neighbors, and of the out-neighbors of v1
+  // and the in-neighbors of v2
+  size_t CountFlows(const VidT v1, const VidT v2) const {
+    ASSERT(v1 < n_ && v2 < n_);
+    const auto common = [](const std::vector<ArrayEntry>& a1,
+                           const std::vector<ArrayEntry>& a2) {
+      size_t cnt = 0;
+      for (size_t p1 = 0, p2 = 0; p1 < a1.size() && p2 < a2.size();) {
+        if (a1[p1].vid == a2[p2].vid) {
+          ++cnt; ++p1; ++p2;
+        } else if (a1[p1].vid < a2[p2].vid) {
+          ++p1;
+        } else {
+          ++p2;
+        }
+      }
+      return cnt;
+    };
+    return common(adj_in[v1], adj_in[v2]) + common(adj_out[v1], adj_out[v2]) +
+           common(adj_out[v1], adj_in[v2]);
+  }
 
 
   // insert an edge (v1, v2) and return its edge ID;
   // the adjacency arrays affected should be sorted later by calling Rectify
 
-  uint32_t DiLazyInsert(const uint32_t v1, const uint32_t v2) {
+  EidT DiLazyInsert(const VidT v1, const VidT v2) {
     ASSERT_MSG(v1 < n_ && v2 < n_, "invalid insertion");
     ASSERT_MSG(m_ + 1 <= l_, "# of edges exceeded");
     // the ID of (v1, v2)
-    const uint32_t eid = free_edges_.back();
+    const EidT eid = free_edges_.back();
     free_edges_.pop_back();
     free_[eid] = false;
     ++m_;
     edge_info_[eid] = {v1, v2};
+    wedges_ += adj_in[v1].size() + adj_out[v2].size();
     // insert the edge to the adjacency arrays
     adj_out[v1].push_back({v2, eid});
     adj_in[v2].push_back({v1, eid});
@@ -249,7 +331,7 @@ class Graph final {
   // sort the adjacency arrays
 
   void DiRectify() {
-    for (uint32_t v = 0; v < n_; ++v) {
+    for (VidT v = 0; v < n_; ++v) {
       std::sort(adj_in[v].begin(), adj_in[v].end(),
                 [](const ArrayEntry& ae1, const ArrayEntry& ae2) {
                   return ae1.vid < ae2.vid;
@@ -273,11 +355,11 @@ class Graph final {
 
   // insert an edge (v1, v2) and return its edge ID
   
-  uint32_t DiInsert(const uint32_t v1, const uint32_t v2) {
+  EidT DiInsert(const VidT v1, const VidT v2) {
     // ASSERT_MSG(v1 < n_ && v2 < n_, "invalid insertion");
     ASSERT_MSG(m_ + 1 <= l_, "# of edges exceeded");
     // the ID of (v1, v2)
-    const uint32_t eid = free_edges_.back();
+    const EidT eid = free_edges_.back();
     // insert the edge to the adjacency arrays
     size_t p1 = 0;
     while (p1 < adj_out[v1].size() && adj_out[v1][p1].vid < v2) ++p1;
@@ -289,7 +371,14 @@ class Graph final {
     ASSERT_MSG(p2 != adj_in[v2].size() ? adj_in[v2][p2].vid > v1 : true,
                "duplicate insertion for adj_in");
     adj_in[v2].insert(adj_in[v2].begin() + p2, {v1, eid});
+    if (kStats) {
+      ++stats_.inserts;
+      stats_.scanned += p1 + p2;
+      stats_.shifted +=
+          adj_out[v1].size() - 1 - p1 + adj_in[v2].size() - 1 - p2;
+    }
     // update other information
+    wedges_ += adj_in[v1].size() + adj_out[v2].size();
     edge_info_[eid] = {v1, v2};
     free_edges_.pop_back();
     free_[eid] = false;
@@ -301,14 +390,14 @@ class Graph final {
   // remove the edge with ID eid
 
   
-  void DiRemove(const uint32_t eid) {
-    const uint32_t v1 = edge_info_.at(eid).first;
-    const uint32_t v2 = edge_info_.at(eid).second;
-    ASSERT_MSG(UINT32_MAX != v1 && UINT32_MAX != v2, "invalid deletion");
+  void DiRemove(const EidT eid) {
+    const VidT v1 = edge_info_.at(eid).first;
+    const VidT v2 = edge_info_.at(eid).second;
+    ASSERT_MSG(kNil != v1 && kNil != v2, "invalid deletion");
     // update information
     free_[eid] = true;
     free_edges_.push_back(eid);
-    edge_info_[eid] = {UINT32_MAX, UINT32_MAX};
+    edge_info_[eid] = {kNil, kNil};
     // remove the edge from the adjacency arrays
     size_t p1 = 0;
     while (adj_out[v1][p1].vid != v2) ++p1;
@@ -316,41 +405,113 @@ class Graph final {
     size_t p2 = 0;
     while (adj_in[v2][p2].vid != v1) ++p2;
     adj_in[v2].erase(adj_in[v2].begin() + p2);
+    if (kStats) {
+      ++stats_.removes;
+      stats_.scanned += p1 + p2;
+      stats_.shifted += adj_out[v1].size() - p1 + adj_in[v2].size() - p2;
+    }
+    wedges_ -= adj_in[v1].size() + adj_out[v2].size();
     // decrease the # of edges
     --m_;
   }
   
   
+  // enlarge the capacity to l edges; the new IDs are allocated after the
+  // IDs that are free at the moment
+  void Reserve(const EidT l) {
+    ASSERT_MSG(l_ <= l && l < (EidT{1} << kIdBits),
+               "invalid capacity");
+    std::vector<EidT> ids(l - l_);
+    std::iota(ids.rbegin(), ids.rend(), l_);
+    free_edges_.insert(free_edges_.begin(), ids.begin(), ids.end());
+    Fit(free_, l, true);
+    Fit(edge_info_, l, EdgT{kNil, kNil});
+    l_ = l;
+  }
+
+  // move the edge with ID eid to the free ID neid;
+  // the list of free IDs is rebuilt by the next call of Shrink
+  void Relabel(const EidT eid, const EidT neid) {
+    ASSERT_MSG(Contain(eid) && !Contain(neid), "invalid relabeling");
+    const VidT v1 = edge_info_[eid].first;
+    const VidT v2 = edge_info_[eid].second;
+    for (auto& ae : adj_out[v1]) {
+      if (ae.vid == v2) ae.eid = neid;
+    }
+    for (auto& ae : adj_in[v2]) {
+      if (ae.vid == v1) ae.eid = neid;
+    }
+    edge_info_[neid] = edge_info_[eid];
+    edge_info_[eid] = {kNil, kNil};
+    free_[neid] = false;
+    free_[eid] = true;
+  }
+
+  // reduce the capacity to l edges; all IDs >= l should be free
+  void Shrink(const EidT l) {
+    ASSERT_MSG(m_ <= l && l <= l_, "invalid capacity");
+    for (EidT eid = l; eid < l_; ++eid) {
+      ASSERT_MSG(free_[eid], "the edge ID to drop is in use");
+    }
+    Fit(free_, l);
+    Fit(edge_info_, l);
+    free_edges_.clear();
+    for (EidT eid = l; eid-- > 0; ) {
+      if (free_[eid]) free_edges_.push_back(eid);
+    }
+    free_edges_.shrink_to_fit();
+    l_ = l;
+  }
+
   // whether the ID eid is valid
-  bool Contain(const uint32_t eid) const {
-    return UINT32_MAX != edge_info_.at(eid).first;
+  bool Contain(const EidT eid) const {
+    return kNil != edge_info_.at(eid).first;
   }
   // accessors
-  uint32_t n() const { return n_; }
-  uint32_t m() const { return m_; }
-  uint32_t l() const { return l_; }
+  VidT n() const { return n_; }
+  EidT m() const { return m_; }
+  EidT l() const { return l_; }
+  size_t InDegree(const VidT v) const { return adj_in[v].size(); }
+  size_t OutDegree(const VidT v) const { return adj_out[v].size(); }
+  const std::vector<ArrayEntry>& InEdges(const VidT v) const {
+    return adj_in[v];
+  }
+  const std::vector<ArrayEntry>& OutEdges(const VidT v) const {
+    return adj_out[v];
+  }
+  // the # of directed 2-paths u -> v -> w, i.e., the total length of the
+  // adjacency arrays scanned when enumerating the cycles of every edge
+  uint64_t wedges() const { return wedges_; }
+  const GraphStats& stats() const { return stats_; }
+  // the bytes held by the adjacency arrays and by the edge records
+  MemoryT Memory() const {
+    return {{"adjacency", Bytes(adj_) + Bytes(adj_in) + Bytes(adj_out)},
+            {"edges", Bytes(free_) + Bytes(free_edges_) + Bytes(edge_info_)}};
+  }
 
  private:
   
-  // the maximum # of edges this strcture can hold;
-  // the current implementation requires l_ < 2^29
-  const uint32_t l_;
+  // the # of edge IDs, i.e., the # of edges this strcture can hold before
+  // Reserve is called; the current implementation requires l_ < 2^kIdBits
+  EidT l_;
   // the # of vertices
-  const uint32_t n_;
+  const VidT n_;
   // the # of edges at the moment; m_ <= l_
-  uint32_t m_;
-  // the truss numbers of the edges
-  const std::vector<int32_t>& k_;
+  EidT m_;
   // free_[i] = true if edge ID i can be allocated; free_.size() == l_
   std::vector<bool> free_;
   // the set of available edge IDs, i.e., the set of IDs i with free_[i] = true
-  std::vector<uint32_t> free_edges_;
+  std::vector<EidT> free_edges_;
+  // the sum of |adj_in[v]| * |adj_out[v]| over all vertices v
+  uint64_t wedges_;
   // adjacency arrays
   std::vector<std::vector<ArrayEntry>> adj_;
   std::vector<std::vector<ArrayEntry>> adj_in;
   std::vector<std::vector<ArrayEntry>> adj_out;
   // edge_info_[i] records the endpoints of the edge with ID i
   std::vector<EdgT> edge_info_;
+  // the counters, which are not saved
+  GraphStats stats_;
 
 
 
@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "defs.h"
+#include "dgraph.h"
+#include "dorder.h"
+#include "dpar.h"
+
+namespace {
+using truss_maint::EdgT;
+using truss_maint::EidT;
+using truss_maint::IncrementalCheck;
+using truss_maint::Order;
+using truss_maint::UpdT;
+using truss_maint::VerifyMode;
+using truss_maint::VidT;
+
+double Ms(const std::chrono::steady_clock::time_point beg) {
+  return std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - beg).count();
+}
+// the nearest-rank percentile of the sorted values
+double Percentile(const std::vector<double>& sorted, const double p) {
+  const size_t rank = static_cast<size_t>(p / 100 * sorted.size() + 0.999999);
+  return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+}  // namespace
+
+// apply an update stream to every layer of an index in batches of BATCH
+// updates, and print the throughput and the latency of the batches as one
+// JSON object; a layer is verified against the ground truth if given
+int main(int argc, char** argv) {
+  ASSERT_MSG(5 == argc || 6 == argc,
+             "usage: dh <INDEX_PATH> <UPDATE_PATH> <insert|delete|mixed> "
+             "<BATCH> [GROUND_TRUTH_PATH]");
+  const std::string index_file = argv[1];
+  const std::string update_file = argv[2];
+  const std::string kind = argv[3];
+  const EidT batch = strtoull(argv[4], nullptr, 10);
+  const std::string ground_truth_file = 6 == argc ? argv[5] : "";
+  ASSERT_MSG("insert" == kind || "delete" == kind || "mixed" == kind,
+             "unknown kind of updates");
+  ASSERT_MSG(batch > 0, "the batch size should be positive");
+  // read the updates, in the format of dm for the kind
+  std::vector<UpdT> updates;
+  std::ifstream inc_file(update_file);
+  ASSERT_MSG(inc_file.is_open(), "cannot open the update file");
+  EidT inc_m = 0; inc_file >> inc_m;
+  for (EidT e = 0; e < inc_m; ++e) {
+    char sign = "insert" == kind ? '+' : '-';
+    if ("mixed" == kind) inc_file >> sign;
+    VidT v1, v2;
+    inc_file >> v1 >> v2;
+    ASSERT_MSG(!inc_file.fail() && ('+' == sign || '-' == sign),
+               "invalid update");
+    updates.push_back({{v1, v2}, '+' == sign});
+  }
+  inc_file.close();
+  // load the layers
+  std::ifstream infile(index_file, std::ios::binary);
+  VidT n = -1;
+  EidT m = -1;
+  infile.read(reinterpret_cast<char*>(&n), sizeof n)
+        .read(reinterpret_cast<char*>(&m), sizeof m);
+  infile.close();
+  const uint32_t layers = truss_maint::IndexLayers(index_file, m);
+  auto beg = std::chrono::steady_clock::now();
+  std::vector<std::unique_ptr<Order>> tms;
+  for (uint32_t curf = 0; curf < layers; ++curf) {
+    tms.emplace_back(new Order(n, m, index_file, curf));
+  }
+  const double load_ms = Ms(beg);
+  // verify as TRUSS_VERIFY says: the incremental checks go with the batches,
+  // and the other modes need the ground truth
+  VerifyMode mode = truss_maint::VerifyModeFromEnv();
+  if (ground_truth_file.empty() && VerifyMode::kIncremental != mode) {
+    mode = VerifyMode::kOff;
+  }
+  std::vector<std::unique_ptr<IncrementalCheck>> checks;
+  for (auto& tm : tms) {
+    checks.emplace_back(new IncrementalCheck(*tm, mode));
+  }
+  double check_ms = 0;
+  // the heap allocations by the updates, without the checks
+  uint64_t allocs = 0;
+  // apply the batches; a single update goes through DiInsert or DiRemove, as
+  // in the serve mode, and a larger batch through DiMixedBatch
+  std::vector<double> lat;
+  const auto all = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < updates.size(); i += batch) {
+    const std::vector<UpdT> part(
+        updates.begin() + i,
+        updates.begin() + std::min(updates.size(), size_t{i + batch}));
+    beg = std::chrono::steady_clock::now();
+    const uint64_t allocs0 = truss_maint::Allocations();
+    for (auto& tm : tms) {
+      if (part.size() > 1) {
+        tm->DiMixedBatch(part);
+      } else if (part[0].second) {
+        tm->DiInsert({part[0].first});
+      } else {
+        tm->DiRemove(part[0].first.first, part[0].first.second);
+      }
+    }
+    lat.push_back(Ms(beg));
+    allocs += truss_maint::Allocations() - allocs0;
+    beg = std::chrono::steady_clock::now();
+    for (auto& check : checks) check->Updated();
+    check_ms += Ms(beg);
+  }
+  beg = std::chrono::steady_clock::now();
+  for (auto& check : checks) check->Wait();
+  check_ms += Ms(beg);
+  const double total_ms = Ms(all);
+  uint64_t tris = 0;
+  for (const auto& tm : tms) tris += tm->tri_cnt();
+  // the incremental checks are followed by a sampled check of the answer
+  for (const auto& tm : tms) {
+    const VerifyMode final_mode =
+        VerifyMode::kIncremental != mode ? mode
+        : ground_truth_file.empty() ? VerifyMode::kOff
+                                    : VerifyMode::kSampled;
+    ASSERT_MSG(0 == tm->Verify(ground_truth_file, final_mode),
+               "wrong answer");
+  }
+  std::sort(lat.begin(), lat.end());
+  printf("{\"index\": \"%s\", \"n\": %" PRIu64 ", \"m\": %" PRIu64
+         ", \"layers\": %u, \"kind\": \"%s\", \"updates\": %zu, "
+         "\"batch\": %" PRIu64 ", \"batches\": %zu, \"threads\": %zu, "
+         "\"load_ms\": %.3f, \"total_ms\": %.3f, \"updates_per_sec\": %.1f, "
+         "\"latency_ms\": {\"min\": %.3f, \"p50\": %.3f, \"p90\": %.3f, "
+         "\"p99\": %.3f, \"max\": %.3f}, \"triangles\": %" PRIu64
+         ", \"allocations_per_update\": %.2f, \"verified\": \"%s\", "
+         "\"check_ms\": %.3f}\n",
+         index_file.c_str(), uint64_t{n}, uint64_t{m}, layers, kind.c_str(),
+         updates.size(), uint64_t{batch}, lat.size(), truss_maint::Threads(),
+         load_ms, total_ms,
+         total_ms > 0 ? updates.size() / total_ms * 1000 : 0.0,
+         lat.empty() ? 0 : lat.front(),
+         lat.empty() ? 0 : Percentile(lat, 50),
+         lat.empty() ? 0 : Percentile(lat, 90),
+         lat.empty() ? 0 : Percentile(lat, 99),
+         lat.empty() ? 0 : lat.back(), tris,
+         updates.empty() ? 0.0 : static_cast<double>(allocs) / updates.size(),
+         truss_maint::VerifyModeName(mode), check_ms);
+}
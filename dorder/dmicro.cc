@@ -0,0 +1,417 @@
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "defs.h"
+#include "dgen.h"
+#include "dgraph.h"
+#include "dorder.h"
+
+namespace truss_maint {
+// reaches the private routines of Order for the benchmarks below
+struct OrderBench final {
+  // insert @e1 right after @e2, as the maintenance algorithms do
+  static void Insert(Order& o, const EidT e1, const EidT e2) {
+    o.OMInsert(e1, e2);
+    o.ListInsert(e1, e2);
+  }
+  static bool Pred(const Order& o, const EidT e1, const EidT e2) {
+    return o.OMPred(e1, e2);
+  }
+  static void Push(Order& o, const EidT e) { o.HPInsert(e); }
+  static void Erase(Order& o, const EidT e) { o.HPDelete(e); }
+  static EidT Top(const Order& o) { return o.HPTop(); }
+  static bool Empty(const Order& o) { return o.hp_tbl_.size() <= 1; }
+  // the edges of the list in its order
+  static std::vector<EidT> List(const Order& o) {
+    std::vector<EidT> es;
+    for (EidT e = o.node_[o.l_].next; kNil != e; e = o.node_[e].next) {
+      es.push_back(e);
+    }
+    return es;
+  }
+};
+}  // namespace truss_maint
+
+namespace {
+using truss_maint::ArrayEntry;
+using truss_maint::Below;
+using truss_maint::EdgT;
+using truss_maint::EidT;
+using truss_maint::Graph;
+using truss_maint::Order;
+using truss_maint::OrderBench;
+using truss_maint::RMat;
+using truss_maint::Rng;
+using truss_maint::Shuffle;
+using truss_maint::VidT;
+
+const uint64_t kSeed = 20240501;
+
+// a sorted adjacency array of d distinct vertices below u
+std::vector<ArrayEntry> Adjacency(const size_t d, const VidT u, Rng& rng) {
+  std::unordered_set<VidT> vs;
+  while (vs.size() < d) vs.insert(Below(rng, u));
+  std::vector<ArrayEntry> adj;
+  for (const VidT v : vs) adj.push_back({v, static_cast<EidT>(adj.size())});
+  std::sort(adj.begin(), adj.end(),
+            [](const ArrayEntry& x, const ArrayEntry& y) {
+              return x.vid < y.vid;
+            });
+  return adj;
+}
+
+// the temporary files of a run; removed on exit
+class Scratch final {
+ public:
+  Scratch() {
+    const char* tmp = getenv("TMPDIR");
+    std::string tmpl = std::string(tmp ? tmp : "/tmp") + "/dmicro.XXXXXX";
+    ASSERT_MSG(nullptr != mkdtemp(&tmpl[0]), "cannot create a scratch dir");
+    dir_ = tmpl;
+  }
+  ~Scratch() {
+    for (const auto& fn : files_) unlink(fn.c_str());
+    rmdir(dir_.c_str());
+  }
+  std::string File(const std::string& name) {
+    files_.push_back(dir_ + "/" + name);
+    return files_.back();
+  }
+
+ private:
+  std::string dir_;
+  std::vector<std::string> files_;
+};
+
+// a decomposed order of the graph with the given edges, saved as a
+// snapshot so that every repetition restores the same state quickly;
+// the capacity is l edge IDs
+std::string Prepare(Scratch& scratch, const std::string& name, const VidT n,
+                    const std::vector<EdgT>& edges, const EidT l) {
+  const std::string index_file = scratch.File(name + ".idx");
+  {
+    // an index with zero trussness; Redecompose computes the real one
+    std::ofstream out(index_file, std::ios::binary);
+    const EidT m = edges.size();
+    out.write(reinterpret_cast<const char*>(&n), sizeof n)
+       .write(reinterpret_cast<const char*>(&m), sizeof m);
+    for (const auto& edge : edges) {
+      const EidT buf[5] = {edge.first, edge.second, 0, 0, 0};
+      out.write(reinterpret_cast<const char*>(buf), sizeof buf);
+    }
+  }
+  Order o(n, l, index_file, 0);
+  o.Redecompose();
+  const std::string snapshot = scratch.File(name + ".snap");
+  o.Save(snapshot);
+  return snapshot;
+}
+
+// times the hot section of a repetition, excluding its set-up
+class Stopwatch final {
+ public:
+  void Start() { beg_ = std::chrono::steady_clock::now(); }
+  void Stop() {
+    ns_ += std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - beg_).count();
+  }
+  double ns() const { return ns_; }
+
+ private:
+  std::chrono::steady_clock::time_point beg_;
+  double ns_ = 0;
+};
+// a benchmark builds fresh inputs on each call, times the operations on
+// them, accumulates a checksum of their results and returns their #; the
+// checksum keeps the results alive and must not vary across runs
+typedef std::function<uint64_t(Stopwatch&, uint64_t&)> BenchFn;
+struct Bench final {
+  std::string name;
+  std::string params;  // a JSON object
+  BenchFn fn;
+};
+
+// the JSON report of one benchmark; one discarded warm-up precedes the
+// timed repetitions
+void Run(const Bench& bench, const int reps, const bool first) {
+  fprintf(stderr, "%s %s\n", bench.name.c_str(), bench.params.c_str());
+  std::vector<double> ns;
+  uint64_t ops = 0, check = 0;
+  for (int r = 0; r <= reps; ++r) {
+    Stopwatch sw;
+    uint64_t chk = 0;
+    const uint64_t cnt = bench.fn(sw, chk);
+    ASSERT_MSG(cnt > 0, "a benchmark without operations");
+    ASSERT_MSG(0 == r || (cnt == ops && chk == check),
+               "a benchmark is not repeatable");
+    ops = cnt;
+    check = chk;
+    if (r > 0) ns.push_back(sw.ns() / cnt);
+  }
+  std::sort(ns.begin(), ns.end());
+  double sum = 0;
+  for (const double x : ns) sum += x;
+  const double median = ns.size() % 2 ? ns[ns.size() / 2] :
+      (ns[ns.size() / 2 - 1] + ns[ns.size() / 2]) / 2;
+  printf("%s\n    {\"name\": \"%s\", \"params\": %s, \"ops\": %" PRIu64
+         ", \"check\": %" PRIu64 ", \"ns_per_op\": {\"min\": %.2f, "
+         "\"median\": %.2f, \"mean\": %.2f, \"max\": %.2f}}",
+         first ? "" : ",", bench.name.c_str(), bench.params.c_str(), ops,
+         check, ns.front(), median, sum / ns.size(), ns.back());
+}
+
+// the graph under the graph and order benchmarks
+const int kScale = 13;
+const EidT kEdges = EidT{1} << 16;
+}  // namespace
+
+// run the microbenchmarks whose names contain FILTER and print the results
+// as JSON to stdout: ./dmb [FILTER [REPS]]
+int main(int argc, char** argv) {
+  ASSERT_MSG(argc <= 3, "usage: dmb [FILTER [REPS]]");
+  const std::string filter = argc >= 2 ? argv[1] : "";
+  const int reps = 3 == argc ? atoi(argv[2]) : 5;
+  ASSERT_MSG(reps > 0, "the # of repetitions should be positive");
+  Scratch scratch;
+  std::vector<Bench> benches;
+  // the intersection of adjacency arrays, by the merge in dorder.cc
+  for (const auto& ds : std::vector<std::pair<size_t, size_t>>{
+           {16, 16}, {16, 1024}, {1024, 16}, {1024, 1024}}) {
+    const size_t d1 = ds.first, d2 = ds.second;
+    benches.push_back({"intersection",
+        "{\"d1\": " + std::to_string(d1) + ", \"d2\": " + std::to_string(d2) +
+        "}", [d1, d2](Stopwatch& sw, uint64_t& check) {
+      // about 2^20 entries scanned in all
+      const size_t calls = std::max<size_t>(1, (1 << 20) / (d1 + d2));
+      const VidT u = 4 * std::max(d1, d2);
+      Rng rng(kSeed);
+      std::vector<std::vector<ArrayEntry>> a1(64), a2(64);
+      for (auto& a : a1) a = Adjacency(d1, u, rng);
+      for (auto& a : a2) a = Adjacency(d2, u, rng);
+      sw.Start();
+      for (size_t i = 0; i < calls; ++i) {
+        check += truss_maint::intersection(a1[i % 64], a2[i % 64]).size();
+      }
+      sw.Stop();
+      return calls;
+    }});
+  }
+  // the cycle and flow triangles of every edge of an R-MAT graph
+  const std::vector<EdgT> rmat = [] {
+    Rng rng(kSeed);
+    return RMat(kScale, kEdges, rng);
+  }();
+  const VidT n = VidT{1} << kScale;
+  const auto load = [n](const std::vector<EdgT>& edges) {
+    Graph g(n, edges.size());
+    for (const auto& edge : edges) g.DiLazyInsert(edge.first, edge.second);
+    g.DiRectify();
+    return g;
+  };
+  const std::string gparams = "{\"graph\": \"rmat\", \"n\": " +
+      std::to_string(n) + ", \"m\": " + std::to_string(kEdges) + "}";
+  benches.push_back({"graph.get_cycles", gparams,
+      [&rmat, &load](Stopwatch& sw, uint64_t& check) {
+    const Graph g = load(rmat);
+    sw.Start();
+    for (EidT e = 0; e < g.m(); ++e) check += g.GetCycles(e).size();
+    sw.Stop();
+    return uint64_t{g.m()};
+  }});
+  benches.push_back({"graph.get_flows", gparams,
+      [&rmat, &load](Stopwatch& sw, uint64_t& check) {
+    const Graph g = load(rmat);
+    const auto kof = [](const EidT) { return 0; };
+    // every 16th edge, as each call clears a flag per vertex
+    sw.Start();
+    for (EidT e = 0; e < g.m(); e += 16) check += g.GetFlows(e, 0, kof).size();
+    sw.Stop();
+    return uint64_t{(g.m() + 15) / 16};
+  }});
+  // edge insertions into and removals from sorted adjacency arrays
+  for (const std::string shape : {"rmat", "star"}) {
+    std::vector<EdgT> edges;
+    if ("rmat" == shape) {
+      edges = rmat;
+    } else {
+      // a hub linked both ways to the other vertices
+      for (VidT v = 1; v < n; ++v) edges.push_back({0, v});
+      for (VidT v = 1; v < n; ++v) edges.push_back({v, 0});
+    }
+    Rng rng(kSeed);
+    Shuffle(edges, rng);
+    const std::string params = "{\"graph\": \"" + shape + "\", \"n\": " +
+        std::to_string(n) + ", \"m\": " + std::to_string(edges.size()) + "}";
+    benches.push_back({"graph.di_insert", params,
+        [edges, n](Stopwatch& sw, uint64_t& check) {
+      Graph g(n, edges.size());
+      sw.Start();
+      for (const auto& edge : edges) g.DiInsert(edge.first, edge.second);
+      sw.Stop();
+      check = g.wedges();
+      return uint64_t{edges.size()};
+    }});
+    benches.push_back({"graph.di_remove", params,
+        [edges, n](Stopwatch& sw, uint64_t& check) {
+      Graph g(n, edges.size());
+      std::vector<EidT> ids;
+      for (const auto& edge : edges) {
+        ids.push_back(g.DiInsert(edge.first, edge.second));
+      }
+      // remove in a different random order
+      Rng rng(kSeed + 1);
+      Shuffle(ids, rng);
+      sw.Start();
+      for (const EidT e : ids) {
+        check += g.wedges();
+        g.DiRemove(e);
+      }
+      sw.Stop();
+      return uint64_t{ids.size()};
+    }});
+  }
+  // order maintenance; the list of the decomposed graph is extended by
+  // kOMInsert IDs beyond its edges, inserted after random edges, or all
+  // after the same edge, which keeps splitting one tag range
+  const EidT kOMInsert = EidT{1} << 14;
+  const std::string om_snap =
+      Prepare(scratch, "om", n, rmat, kEdges + kOMInsert);
+  const std::string oparams = "{\"graph\": \"rmat\", \"n\": " +
+      std::to_string(n) + ", \"m\": " + std::to_string(kEdges) +
+      ", \"inserts\": " + std::to_string(kOMInsert);
+  for (const bool adversarial : {false, true}) {
+    benches.push_back({"order.om_insert", oparams + ", \"pattern\": \"" +
+        (adversarial ? "same" : "random") + "\"}",
+        [om_snap, adversarial](Stopwatch& sw, uint64_t& check) {
+      Order o(om_snap);
+      std::vector<EidT> list = OrderBench::List(o);
+      Rng rng(kSeed);
+      std::vector<EidT> after(kOMInsert);
+      for (auto& e : after) e = adversarial ? list[0] : list[Below(rng, kEdges)];
+      sw.Start();
+      for (EidT i = 0; i < kOMInsert; ++i) {
+        OrderBench::Insert(o, kEdges + i, after[i]);
+      }
+      sw.Stop();
+      // the order should agree with the list
+      list = OrderBench::List(o);
+      for (size_t i = 1; i < list.size(); ++i) {
+        check += OrderBench::Pred(o, list[i - 1], list[i]);
+      }
+      return uint64_t{kOMInsert};
+    }});
+  }
+  benches.push_back({"order.om_pred", oparams + "}",
+      [om_snap](Stopwatch& sw, uint64_t& check) {
+    Order o(om_snap);
+    Rng rng(kSeed);
+    std::vector<EidT> list = OrderBench::List(o);
+    for (EidT i = 0; i < kOMInsert; ++i) {
+      OrderBench::Insert(o, kEdges + i, list[Below(rng, kEdges)]);
+    }
+    list = OrderBench::List(o);
+    const size_t queries = size_t{1} << 20;
+    std::vector<std::pair<EidT, EidT>> pairs(queries);
+    for (auto& p : pairs) {
+      p = {list[Below(rng, list.size())], list[Below(rng, list.size())]};
+    }
+    sw.Start();
+    for (const auto& p : pairs) check += OrderBench::Pred(o, p.first, p.second);
+    sw.Stop();
+    return uint64_t{queries};
+  }});
+  // the heap keyed by the order: pushes followed by pops of the top, or by
+  // deletions in a random order
+  const EidT kHeap = EidT{1} << 14;
+  for (const bool pop : {true, false}) {
+    benches.push_back({pop ? "order.heap_push_pop" : "order.heap_push_delete",
+        oparams + ", \"size\": " + std::to_string(kHeap) + "}",
+        [om_snap, kHeap, pop](Stopwatch& sw, uint64_t& check) {
+      Order o(om_snap);
+      Rng rng(kSeed);
+      std::vector<EidT> es = OrderBench::List(o);
+      Shuffle(es, rng);
+      es.resize(kHeap);
+      std::vector<EidT> dels = es;
+      Shuffle(dels, rng);
+      std::vector<EidT> tops;
+      tops.reserve(kHeap);
+      sw.Start();
+      for (const EidT e : es) OrderBench::Push(o, e);
+      if (pop) {
+        while (!OrderBench::Empty(o)) {
+          tops.push_back(OrderBench::Top(o));
+          OrderBench::Erase(o, tops.back());
+        }
+      } else {
+        for (const EidT e : dels) OrderBench::Erase(o, e);
+      }
+      sw.Stop();
+      // the tops should come out in the order
+      for (size_t i = 1; i < tops.size(); ++i) {
+        check += OrderBench::Pred(o, tops[i - 1], tops[i]);
+      }
+      return uint64_t{2 * kHeap};
+    }});
+  }
+  // the maintenance of the decomposed graph under updates of sampled edges:
+  // insertions into the graph without them, or removals from the full graph
+  Rng rng(kSeed);
+  std::vector<EdgT> sample = rmat;
+  Shuffle(sample, rng);
+  const std::vector<EdgT> rest(sample.begin() + kEdges / 50, sample.end());
+  sample.resize(kEdges / 50);
+  const std::string full_snap = Prepare(scratch, "full", n, rmat, kEdges);
+  const std::string rest_snap = Prepare(scratch, "rest", n, rest, kEdges);
+  const std::vector<EdgT> unit(sample.begin(), sample.begin() + 256);
+  const auto update = [&](const std::string& name,
+                          const std::vector<EdgT>& edges,
+                          const std::string& snap,
+                          const std::function<void(Order&)>& op) {
+    benches.push_back({name, "{\"graph\": \"rmat\", \"n\": " +
+        std::to_string(n) + ", \"m\": " + std::to_string(kEdges) +
+        ", \"updates\": " + std::to_string(edges.size()) + "}",
+        [edges, snap, op](Stopwatch& sw, uint64_t& check) {
+      Order o(snap);
+      sw.Start();
+      op(o);
+      sw.Stop();
+      check = o.tri_cnt();
+      for (const int32_t k : o.k()) check += k + 1;
+      return uint64_t{edges.size()};
+    }});
+  };
+  update("order.di_insert", unit, rest_snap, [unit](Order& o) {
+    for (const auto& edge : unit) o.DiInsert({edge});
+  });
+  update("order.di_remove", unit, full_snap, [unit](Order& o) {
+    for (const auto& edge : unit) o.DiRemove(edge.first, edge.second);
+  });
+  update("order.di_batch_insert", sample, rest_snap, [sample](Order& o) {
+    o.DiBatchInsert(sample);
+  });
+  update("order.di_batch_remove", sample, full_snap, [sample](Order& o) {
+    o.DiBatchRemove(sample);
+  });
+  // run
+  printf("{\n  \"suite\": \"dmicro\", \"id_bytes\": %zu, \"seed\": %" PRIu64
+         ", \"reps\": %d,\n  \"benchmarks\": [", sizeof(EidT), kSeed, reps);
+  bool first = true;
+  for (const auto& bench : benches) {
+    if (std::string::npos == bench.name.find(filter)) continue;
+    Run(bench, reps, first);
+    first = false;
+  }
+  printf("\n  ]\n}\n");
+}
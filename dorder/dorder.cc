@@ -1,31 +1,62 @@
 #include "dorder.h"
 
+#include <sys/wait.h>
+#include <unistd.h>
+
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
 #include <fstream>
+#include <mutex>
+#include <numeric>
 #include <tuple>
 #include <utility>
 
 #include "defs.h"
+#include "dpar.h"
+#include "dreorder.h"
+#include "dskyline.h"
+#include "dtrace.h"
 
 namespace truss_maint {
 
+std::atomic<uint64_t> allocation_count{0};
+uint64_t Allocations() {
+  return allocation_count.load(std::memory_order_relaxed);
+}
 
+namespace {
+// the # of edges in the header of the index file @fn
+EidT IndexEdges(const std::string& fn) {
+  std::ifstream infile(fn, std::ios::binary);
+  ASSERT_MSG(infile.is_open(), "cannot open the index file");
+  VidT gn = 0;
+  EidT gm = 0;
+  infile.read(reinterpret_cast<char*>(&gn), sizeof gn)
+        .read(reinterpret_cast<char*>(&gm), sizeof gm);
+  return gm;
+}
+}  // namespace
 
-Order::Order(const uint32_t n, const uint32_t l, const std::string& fn, uint32_t curf)
-    : l_(l), n_(n), g_(n_, l_, k_) {
-  ASSERT_MSG(64 <= l_ && l_ < (static_cast<uint32_t>(1) << 29),
-             "it is required 64 <= l <= 2^29 for the ease of implementation");
-  k_    = std::vector<int32_t>(l_, -1);
+Order::Order(const VidT n, const EidT l, const std::string& fn, uint32_t curf)
+    : l_(std::max({l, IndexEdges(fn), static_cast<EidT>(64)})),
+      n_(n), g_(n_, l_) {
+  ASSERT_MSG(l_ < (EidT{1} << kIdBits),
+             "it is required l < 2^29 for the ease of implementation");
+  // @l_ is the head of the list, so both records have l_ + 1 entries
+  hot_  = std::vector<EdgeHot>(l_ + 1);
+  for (auto& h : hot_) h.k = -1;
   node_ = std::vector<ListNode>(l_ + 1);
-  new_  = std::vector<bool>(l_, false);
-  chg_  = std::vector<bool>(l_, false);
-  ts_   = std::vector<uint32_t>(l_, 0);
-  s_    = std::vector<uint32_t>(l_, 0);
   // initialize the heap
   HPInit();
   // load index
   std::ifstream infile(fn, std::ios::binary);
-  uint32_t gn = 0, gm = 0;
+  VidT gn = 0;
+  EidT gm = 0;
   infile.read(reinterpret_cast<char*>(&gn), sizeof gn)
         .read(reinterpret_cast<char*>(&gm), sizeof gm);
   ASSERT(gm <= l_ && n_ == gn);
@@ -34,110 +65,233 @@ Order::Order(const uint32_t n, const uint32_t l, const std::string& fn, uint32_t
 
 
 
-void Order::LoadIndex(const std::string& fn, uint32_t m, uint32_t n, uint32_t curf) {
+Order::Order(const std::string& snapshot)
+    : Order(SnapReader(snapshot, sizeof(EidT))) {}
+
+Order::Order(SnapReader&& snap)
+    : l_(snap.Get<EidT>()), n_(snap.Get<VidT>()), g_(snap) {
+  snap.GetVec(hot_);
+  snap.GetVec(node_);
+  snap.GetVec(head_);
+  snap.GetVec(tail_);
+  snap.GetNested(vhist_);
+  tri_cnt_ = snap.Get<uint64_t>();
+  om_avail_ = snap.Get<EidT>();
+  snap.GetVec(om_nodes_);
+  snap.GetVec(om_cnt_);
+  snap.GetVec(hp_tbl_);
+  snap.GetVec(hp_pos_);
+  ASSERT_MSG(snap.Done() && l_ == g_.l() && l_ + 1 == hot_.size() &&
+             l_ + 1 == node_.size() && n_ == vhist_.size(),
+             "corrupted snapshot");
+}
+
+void Order::Save(const std::string& fn) const {
+  const std::string tmp = fn + ".tmp";
+  SnapWriter snap(tmp, sizeof(EidT));
+  snap.Put(l_);
+  snap.Put(n_);
+  g_.Save(snap);
+  snap.PutVec(hot_);
+  snap.PutVec(node_);
+  snap.PutVec(head_);
+  snap.PutVec(tail_);
+  snap.PutNested(vhist_);
+  snap.Put(tri_cnt_);
+  snap.Put(om_avail_);
+  snap.PutVec(om_nodes_);
+  snap.PutVec(om_cnt_);
+  snap.PutVec(hp_tbl_);
+  snap.PutVec(hp_pos_);
+  snap.Close();
+  // a crash while saving leaves the previous snapshot intact
+  ASSERT_MSG(0 == std::rename(tmp.c_str(), fn.c_str()),
+             "cannot replace the snapshot");
+}
+
+void Order::LoadIndex(const std::string& fn, EidT m, VidT n, uint32_t curf) {
+  TraceScope trace("LoadIndex", "layer", curf);
   // read data; no exception handling here
   std::ifstream infile(fn, std::ios::binary);
-  // uint32_t n = 0, m = 0;
+  // EidT n = 0, m = 0;
   infile.read(reinterpret_cast<char*>(&n), sizeof n)
         .read(reinterpret_cast<char*>(&m), sizeof m);
   ASSERT(m <= l_ && n_ == n);
-  // read the edges and their information
-  for (uint32_t e = m * curf, buf[5]; e < m * (curf+1); ++e) {
-    infile.read(reinterpret_cast<char*>(buf), sizeof buf);
-    // insert the edge (buf[0], buf[1])
-    // ASSERT(g_.LazyInsert(buf[0], buf[1]) == e);
-    ASSERT(g_.DiLazyInsert(buf[0], buf[1]) == e - (m * curf));
-    // set the truss number, remaining support, and triangle support
-    k_[e - (m * curf)] = static_cast<int32_t>(buf[2]);
-    node_[e - (m * curf)].rem = buf[3]; ts_[e - (m * curf)] = buf[4];
-    // check
-    ASSERT_MSG(e - (m * curf) > 0 ? k_[e - (m * curf)] >= k_[e - (m * curf) - 1] : true, "not in order");
+  auto beg = std::chrono::steady_clock::now();
+  const auto lap = [this, &beg](const char* part) {
+    const auto now = std::chrono::steady_clock::now();
+    load_ms_.push_back(
+        {part, std::chrono::duration<double, std::milli>(now - beg).count()});
+    beg = now;
+  };
+  // read the records; the trussness is non-decreasing along them
+  std::vector<EidT> recs(size_t{m} * 5);
+  infile.read(reinterpret_cast<char*>(recs.data()),
+              recs.size() * sizeof(EidT));
+  infile.close();
+  for (EidT i = 0; i < m; ++i) {
+    const EidT* buf = &recs[size_t{i} * 5];
+    ASSERT_MSG(i > 0 ? buf[2] >= buf[-3] : true, "not in order");
     ASSERT_MSG(buf[3] <= buf[2], "invalid remaining support or truss number");
   }
-  infile.close();
+  lap("read");
+  // the edge IDs follow the records, or with TRUSS_REORDER the ranks of the
+  // endpoints, so that the edges of a vertex and of its neighbors get
+  // nearby IDs; rec[e] is the record of the edge with ID e, and the vertex
+  // IDs are kept, so nothing outside the order sees the relabeling
+  std::vector<EidT> rec(m);
+  std::iota(rec.begin(), rec.end(), 0);
+  const Reorder reorder = ReorderFromEnv();
+  if (Reorder::kOff != reorder) {
+    std::vector<EdgT> edges(m);
+    for (EidT i = 0; i < m; ++i) {
+      edges[i] = {recs[size_t{i} * 5], recs[size_t{i} * 5 + 1]};
+    }
+    const std::vector<VidT> rank = VertexRank(n_, edges, reorder);
+    std::sort(rec.begin(), rec.end(), [&edges, &rank](const EidT a,
+                                                      const EidT b) {
+      return std::make_pair(rank[edges[a].first], rank[edges[a].second]) <
+             std::make_pair(rank[edges[b].first], rank[edges[b].second]);
+    });
+    lap("reorder");
+  }
+  // insert the edges, and set their truss numbers, remaining supports and
+  // triangle supports
+  std::vector<EidT> ord(m);
+  for (EidT e = 0; e < m; ++e) {
+    const EidT* buf = &recs[size_t{rec[e]} * 5];
+    ASSERT(g_.DiLazyInsert(buf[0], buf[1]) == e);
+    hot_[e].k = static_cast<int32_t>(buf[2]);
+    hot_[e].rem = buf[3];
+    hot_[e].ts = buf[4];
+    ord[rec[e]] = e;
+  }
+  decltype(recs)().swap(recs);
+  lap("insert");
   // rectify the graph
-  
   g_.DiRectify();
   ASSERT(g_.m() == m);
-  // reconstruct the list; @l_ is always the head of the list
-  uint32_t prev_e = l_;
-  node_[l_].prev = node_[l_].next = UINT32_MAX;
-  for (uint32_t e = 0; e < m; ++e) {
-    const uint32_t k = k_[e];
-    // the sublist of all edges with trussness k
-    if (head_.size() <= k) {
-      ASSERT(head_.size() == tail_.size());
-      head_.resize(k + 1, UINT32_MAX);
-      tail_.resize(k + 1, UINT32_MAX);
-      head_[k] = e;
-    }
-    tail_[k] = e;
-    // set the list node
-    node_[prev_e].next = e;
-    node_[e].prev = prev_e;
-    node_[e].next = UINT32_MAX;
-    node_[e].ext = 0;
-    // set e as the new prev_e
-    prev_e = e;
-  }
+  lap("rectify");
+  // reconstruct the list in the order of the records
+  ListLoad(ord);
+  lap("list");
   // order maintenance structure
   OMLoad();
+  lap("om");
+  VertexLoad();
+  lap("vertex");
+}
+
+std::vector<int32_t> Order::k() const {
+  std::vector<int32_t> k(l_);
+  for (EidT e = 0; e < l_; ++e) k[e] = hot_[e].k;
+  return k;
+}
+
+EidT Order::First(const int32_t k) const {
+  size_t kk = std::max(k, 0);
+  while (kk < head_.size() && kNil == head_[kk]) ++kk;
+  return kk < head_.size() ? head_[kk] : kNil;
+}
+
+std::vector<EdgT> Order::Edges(const int32_t k) const {
+  std::vector<EdgT> edges;
+  // the list is sorted by trussness, so the answer is a suffix of it
+  for (EidT e = First(k); kNil != e; e = node_[e].next) {
+    edges.push_back(g_.Get(e));
+  }
+  return edges;
+}
+
+std::vector<std::pair<EidT, EidT>> Order::Communities(const int32_t k,
+                                                      const VidT q) {
+  std::vector<std::pair<EidT, EidT>> comms;
+  if (q >= n_) return comms;
+  CommLevel& c = CommLoad(std::max(k, 0));
+  for (const auto* adj : {&g_.InEdges(q), &g_.OutEdges(q)}) {
+    for (const auto ae : *adj) {
+      if (hot_[ae.eid].k < k) continue;
+      const EidT r = CommFind(c, ae.eid);
+      comms.push_back({r, c.size[r]});
+    }
+  }
+  std::sort(comms.begin(), comms.end());
+  comms.erase(std::unique(comms.begin(), comms.end()), comms.end());
+  return comms;
+}
+
+std::vector<EdgT> Order::Members(const int32_t k, const EidT c) {
+  std::vector<EdgT> edges;
+  if (c >= l_) return edges;
+  CommLevel& level = CommLoad(std::max(k, 0));
+  for (EidT e = First(k); kNil != e; e = node_[e].next) {
+    if (c == CommFind(level, e)) edges.push_back(g_.Get(e));
+  }
+  return edges;
 }
 
 void Order::DiInsert(const std::vector<EdgT>& nedges) {
+  TraceScope trace("DiInsert", "edges", nedges.size());
   ASSERT(!nedges.empty());
+  const uint64_t tris = tri_cnt_;
+  const uint64_t allocs = Allocations();
+  Reserve(g_.m() + nedges.size());
   // initialization
-  std::vector<uint32_t> N;
+  std::vector<EidT>& N = buf_.cand;
+  N.clear();
   for (const auto edge : nedges) {
-    const uint32_t e = g_.DiInsert(edge.first, edge.second);
+    const EidT e = g_.DiInsert(edge.first, edge.second);
     N.push_back(e);
-    new_[e] = true;
+    hot_[e].fresh = true;
   }
-  for (const uint32_t e : N) {
-    chg_[e] = true;
+  for (const EidT e : N) {
+    hot_[e].chg = true;
     // assume the trussness is -1
-    k_[e] = -1;
+    SetK(e, -1);
     // update @s and &ts
     // const auto tris = g_.GetTriangles(e);
-    const auto tris = g_.GetCycles(e);
-    s_[e] = ts_[e] = tris.size();
+    const auto& tris = Cycles(e);
+    hot_[e].s = hot_[e].ts = tris.size();
     // update @ext
     for (const auto tri : tris) {
-      const uint32_t e1 = tri.first;
-      const uint32_t e2 = tri.second;
-      if (!new_[e1] && (chg_[e2] || (!new_[e2] && OMPred(e1, e2)))) {
-        if (1 == ++node_[e1].ext) HPInsert(e1);
+      const EidT e1 = tri.first;
+      const EidT e2 = tri.second;
+      if (!hot_[e1].fresh && (hot_[e2].chg || (!hot_[e2].fresh && OMPred(e1, e2)))) {
+        if (1 == IncExt(e1)) HPInsert(e1);
       }
-      if (!new_[e2] && (chg_[e1] || (!new_[e1] && OMPred(e2, e1)))) {
-        if (1 == ++node_[e2].ext) HPInsert(e2);
+      if (!hot_[e2].fresh && (hot_[e1].chg || (!hot_[e1].fresh && OMPred(e2, e1)))) {
+        if (1 == IncExt(e2)) HPInsert(e2);
       }
     }
-    node_[e].ext = 0;
+    hot_[e].ext = 0;
   }
-  for (const uint32_t e : N) new_[e] = false;
+  for (const EidT e : N) hot_[e].fresh = false;
   // the last processed edge
-  uint32_t le = l_;
+  EidT le = l_;
   // simulate
   for (int32_t k = 0; true; ++k) {
     if (N.empty()) break;
+    if (kStats) CountCandidates(k, N.size());
     // expand the head and tail arrays
     ASSERT(head_.size() == tail_.size());
     while (head_.size() <= static_cast<size_t>(k)) {
-      head_.push_back(UINT32_MAX);
-      tail_.push_back(UINT32_MAX);
+      head_.push_back(kNil);
+      tail_.push_back(kNil);
     }
     // a stack for DFS
-    std::vector<uint32_t> S;
-    const auto pred = [this, k](const uint32_t e){return uint32_t(k) >= s_[e];};
+    std::vector<EidT>& S = buf_.stack;
+    S.clear();
+    const auto pred = [this, k](const EidT e){return uint32_t(k) >= hot_[e].s;};
     // P1 stores the edges removed in the first shrink
-    std::vector<uint32_t> P1;
+    std::vector<EidT>& P1 = buf_.p1;
+    P1.clear();
     // first shrink
     std::copy_if(N.begin(), N.end(), std::back_inserter(S), pred);
     while (!S.empty()) {
-      const uint32_t e = S.back(); S.pop_back();
+      const EidT e = S.back(); S.pop_back();
       // update the information of e
-      std::tie(node_[e].rem, s_[e], ts_[e]) = std::make_tuple(s_[e], 0, 0);
-      chg_[e] = false;
+      std::tie(hot_[e].rem, hot_[e].s, hot_[e].ts) = std::make_tuple(hot_[e].s, 0, 0);
+      hot_[e].chg = false;
       P1.push_back(e);
       // insert the edge to the order and the list
       OMInsert(e, le);
@@ -145,127 +299,128 @@ void Order::DiInsert(const std::vector<EdgT>& nedges) {
       le = e;
       // find more edges to shrink and upate the ts values of related edges
       // const auto tris = g_.GetTriangles(e);
-      const auto tris = g_.GetCycles(e);
+      const auto& tris = Cycles(e);
       for (const auto tri : tris) {
-        const uint32_t e1 = tri.first;
-        const uint32_t e2 = tri.second;
+        const EidT e1 = tri.first;
+        const EidT e2 = tri.second;
         // update @ts values
-        const int32_t min_k = std::min(k_[e1], k_[e2]);
-        const int32_t ori_k = std::min(min_k, k_[e]);
+        const int32_t min_k = std::min(hot_[e1].k, hot_[e2].k);
+        const int32_t ori_k = std::min(min_k, hot_[e].k);
         const int32_t cur_k = std::min(min_k, k);
-        if (ori_k < k_[e1] && cur_k >= k_[e1]) ++ts_[e1];
-        if (ori_k < k_[e2] && cur_k >= k_[e2]) ++ts_[e2];
-        if (cur_k >= k) ++ts_[e];
+        if (ori_k < hot_[e1].k && cur_k >= hot_[e1].k) ++hot_[e1].ts;
+        if (ori_k < hot_[e2].k && cur_k >= hot_[e2].k) ++hot_[e2].ts;
+        if (cur_k >= k) ++hot_[e].ts;
         // update @s and @ext values
-        if (!chg_[e1] && !OMPred(e, e1)) continue;
-        if (!chg_[e2] && !OMPred(e, e2)) continue;
-        if (chg_[e1]) {
-          if (static_cast<uint32_t>(k) == --s_[e1]) S.push_back(e1);
-        } else if (chg_[e2] || OMPred(e1, e2)) {
-          if (0 == --node_[e1].ext) HPDelete(e1);
+        if (!hot_[e1].chg && !OMPred(e, e1)) continue;
+        if (!hot_[e2].chg && !OMPred(e, e2)) continue;
+        if (hot_[e1].chg) {
+          if (static_cast<uint32_t>(k) == --hot_[e1].s) S.push_back(e1);
+        } else if (hot_[e2].chg || OMPred(e1, e2)) {
+          if (0 == --hot_[e1].ext) HPDelete(e1);
         }
-        if (chg_[e2]) {
-          if (static_cast<uint32_t>(k) == --s_[e2]) S.push_back(e2);
-        } else if (chg_[e1] || OMPred(e2, e1)) {
-          if (0 == --node_[e2].ext) HPDelete(e2);
+        if (hot_[e2].chg) {
+          if (static_cast<uint32_t>(k) == --hot_[e2].s) S.push_back(e2);
+        } else if (hot_[e1].chg || OMPred(e2, e1)) {
+          if (0 == --hot_[e2].ext) HPDelete(e2);
         }
       }
       // update the trussness
-      k_[e] = k;
+      SetK(e, k);
     } {
       const auto it = std::copy_if(N.begin(), N.end(), N.begin(),
-          [this](const uint32_t e){return chg_[e];});
+          [this](const EidT e){return hot_[e].chg;});
       N.resize(std::distance(N.begin(), it));
     }
     // update the head and tail
     if (!P1.empty()) {
       head_[k] = P1[0];
-      if (UINT32_MAX == tail_[k]) tail_[k] = P1.back();
+      if (kNil == tail_[k]) tail_[k] = P1.back();
     }
     // there are edges with trussness k in the heap
-    while (hp_tbl_.size() > 1 && k_[HPTop()] == k) {
-      const uint32_t e = HPTop(); HPDelete(e);
-      const uint32_t s = node_[e].ext + node_[e].rem;
+    while (hp_tbl_.size() > 1 && hot_[HPTop()].k == k) {
+      const EidT e = HPTop(); HPDelete(e);
+      const uint32_t s = hot_[e].ext + hot_[e].rem;
       // e* of Type-2
       if (s > static_cast<uint32_t>(k)) {
-        std::tie(s_[e], node_[e].ext) = std::make_tuple(s, 0);
+        hot_[e].s = s;  hot_[e].ext = 0;
         N.push_back(e);
-        chg_[e] = true;
+        hot_[e].chg = true;
         // update the ext values
         // const auto tris = g_.GetTriangles(e);
-        const auto tris = g_.GetCycles(e);
+        const auto& tris = Cycles(e);
         for (const auto tri : tris) {
-          const uint32_t e1 = tri.first;
-          const uint32_t e2 = tri.second;
-          if (!chg_[e1] && OMPred(e, e1) && (chg_[e2] || OMPred(e1, e2))) {
-            if (1 == ++node_[e1].ext) HPInsert(e1);
+          const EidT e1 = tri.first;
+          const EidT e2 = tri.second;
+          if (!hot_[e1].chg && OMPred(e, e1) && (hot_[e2].chg || OMPred(e1, e2))) {
+            if (1 == IncExt(e1)) HPInsert(e1);
           }
-          if (!chg_[e2] && OMPred(e, e2) && (chg_[e1] || OMPred(e2, e1))) {
-            if (1 == ++node_[e2].ext) HPInsert(e2);
+          if (!hot_[e2].chg && OMPred(e, e2) && (hot_[e1].chg || OMPred(e2, e1))) {
+            if (1 == IncExt(e2)) HPInsert(e2);
           }
         }
         // remove the edge from the list and the order
         ListRemove(e, head_[k], tail_[k]);
         OMRemove(e);
       } else { // e* of Type-3
-        std::tie(node_[e].rem, node_[e].ext) = std::make_tuple(s, 0);
+        hot_[e].rem = s;  hot_[e].ext = 0;
         // const auto tris = g_.GetTriangles(e);
-        const auto tris = g_.GetCycles(e);
+        const auto& tris = Cycles(e);
         for (const auto tri : tris) {
-          const uint32_t e1 = tri.first;
-          const uint32_t e2 = tri.second;
-          if (chg_[e1] && (chg_[e2] || OMPred(e, e2))) {
-            if (static_cast<uint32_t>(k) >= --s_[e1]) S.push_back(e1);
+          const EidT e1 = tri.first;
+          const EidT e2 = tri.second;
+          if (hot_[e1].chg && (hot_[e2].chg || OMPred(e, e2))) {
+            if (static_cast<uint32_t>(k) >= --hot_[e1].s) S.push_back(e1);
           }
-          if (chg_[e2] && (chg_[e1] || OMPred(e, e1))) {
-            if (static_cast<uint32_t>(k) >= --s_[e2]) S.push_back(e2);
+          if (hot_[e2].chg && (hot_[e1].chg || OMPred(e, e1))) {
+            if (static_cast<uint32_t>(k) >= --hot_[e2].s) S.push_back(e2);
           }
         }
         // P3 stores the edges removed from the candidate set
-        std::vector<uint32_t> P3;
+        std::vector<EidT>& P3 = buf_.p3;
+        P3.clear();
         // remove edges from the candidate set
         while (!S.empty()) {
-          const uint32_t ee = S.back(); S.pop_back();
+          const EidT ee = S.back(); S.pop_back();
           // update the status of the edge
-          std::tie(node_[ee].rem, s_[ee]) = std::make_tuple(s_[ee], 0);
-          chg_[ee] = false;  new_[ee] = true;
+          std::tie(hot_[ee].rem, hot_[ee].s) = std::make_tuple(hot_[ee].s, 0);
+          hot_[ee].chg = false;  hot_[ee].fresh = true;
           P3.push_back(ee);
-          if (k_[ee] != k) {
-            ts_[ee] = 0;
+          if (hot_[ee].k != k) {
+            hot_[ee].ts = 0;
           }
           // const auto tris = g_.GetTriangles(ee);
-          const auto tris = g_.GetCycles(ee);
+          const auto& tris = Cycles(ee);
           for (const auto tri : tris) {
-            const uint32_t e1 = tri.first;
-            const uint32_t e2 = tri.second;
-            if (k_[ee] != k) {
-              const int32_t min_k = std::min(k_[e1], k_[e2]);
-              const int32_t ori_k = std::min(min_k, k_[ee]);
+            const EidT e1 = tri.first;
+            const EidT e2 = tri.second;
+            if (hot_[ee].k != k) {
+              const int32_t min_k = std::min(hot_[e1].k, hot_[e2].k);
+              const int32_t ori_k = std::min(min_k, hot_[ee].k);
               const int32_t cur_k = std::min(min_k, k);
-              if (ori_k < k_[e1] && cur_k >= k_[e1]) ++ts_[e1];
-              if (ori_k < k_[e2] && cur_k >= k_[e2]) ++ts_[e2];
-              if (cur_k >= k) ++ts_[ee];
+              if (ori_k < hot_[e1].k && cur_k >= hot_[e1].k) ++hot_[e1].ts;
+              if (ori_k < hot_[e2].k && cur_k >= hot_[e2].k) ++hot_[e2].ts;
+              if (cur_k >= k) ++hot_[ee].ts;
             }
-            if (new_[e1] || (!chg_[e1] && !OMPred(e, e1))) continue;
-            if (new_[e2] || (!chg_[e2] && !OMPred(e, e2))) continue;
-            if (chg_[e1]) {
-              if (static_cast<uint32_t>(k) == --s_[e1]) S.push_back(e1);
-            } else if (chg_[e2] || OMPred(e1, e2)) {
-              if (0 == --node_[e1].ext) HPDelete(e1);
+            if (hot_[e1].fresh || (!hot_[e1].chg && !OMPred(e, e1))) continue;
+            if (hot_[e2].fresh || (!hot_[e2].chg && !OMPred(e, e2))) continue;
+            if (hot_[e1].chg) {
+              if (static_cast<uint32_t>(k) == --hot_[e1].s) S.push_back(e1);
+            } else if (hot_[e2].chg || OMPred(e1, e2)) {
+              if (0 == --hot_[e1].ext) HPDelete(e1);
             }
-            if (chg_[e2]) {
-              if (static_cast<uint32_t>(k) == --s_[e2]) S.push_back(e2);
-            } else if (chg_[e1] || OMPred(e2, e1)) {
-              if (0 == --node_[e2].ext) HPDelete(e2);
+            if (hot_[e2].chg) {
+              if (static_cast<uint32_t>(k) == --hot_[e2].s) S.push_back(e2);
+            } else if (hot_[e1].chg || OMPred(e2, e1)) {
+              if (0 == --hot_[e2].ext) HPDelete(e2);
             }
           }
           // update the trussness
-          k_[ee] = k;
+          SetK(ee, k);
         }
         // insert the edges in P3 to the order and the list
         le = e;
-        for (const uint32_t ee : P3) {
-          new_[ee] = false;
+        for (const EidT ee : P3) {
+          hot_[ee].fresh = false;
           OMInsert(ee, le);
           ListInsert(ee, le);
           le = ee;
@@ -276,63 +431,86 @@ void Order::DiInsert(const std::vector<EdgT>& nedges) {
     }
     // shrink N
     const auto it = std::copy_if(N.begin(), N.end(), N.begin(),
-        [this](const uint32_t e){return chg_[e];});
+        [this](const EidT e){return hot_[e].chg;});
     N.resize(std::distance(N.begin(), it));
     // update the last processed edge
-    if (UINT32_MAX != tail_[k]) le = tail_[k];
+    if (kNil != tail_[k]) le = tail_[k];
+  }
+  if (kStats) {
+    stats_.insert.Count(nedges.size(), tri_cnt_ - tris, Allocations() - allocs);
   }
 }
 
 void Order::DiBatchInsert(const std::vector<EdgT>& nedges) {
+  TraceScope trace("DiBatchInsert", "edges", nedges.size());
   ASSERT(nedges.size() > size_t{g_.m()} / 100);
+  const uint64_t tris = tri_cnt_;
+  const uint64_t allocs = Allocations();
+  Reserve(g_.m() + nedges.size());
   // initilize the rank
-  for (uint32_t r = 0, e = l_; UINT32_MAX != e; e = node_[e].next) {
-    rank_[e] = ++r;
-  }
+  RankLoad();
   // the candidate set
-  std::vector<uint32_t> N;
+  std::vector<EidT>& N = buf_.cand;
+  N.clear();
   for (const auto edg : nedges) N.push_back(g_.DiInsert(edg.first, edg.second));
-  for (const uint32_t e : N) rank_[e] = 0;
-  for (const uint32_t e : N) {
-    chg_[e] = true;
+  for (const EidT e : N) rank_[e] = 0;
+  // the graph is fixed from now on, so the triangles needed by the
+  // simulation are enumerated in parallel ahead of it; the updates are
+  // applied sequentially in the same order as before
+  Prefetch(N);
+  for (const EidT e : N) {
+    hot_[e].chg = true;
     // assume the trussness is -1
-    k_[e] = -1;
+    SetK(e, -1);
     // update @s and &ts
     // const auto tris = g_.GetTriangles(e);
-    const auto tris = g_.GetCycles(e);
-    s_[e] = ts_[e] = tris.size();
+    const auto& tris = Cycles(e);
+    hot_[e].s = hot_[e].ts = tris.size();
     // update @ext
     for (const auto tri : tris) {
-      const uint32_t e1 = tri.first;
-      const uint32_t e2 = tri.second;
-      if (rank_[e1] && (chg_[e2] || rank_[e2] > rank_[e1])) ++node_[e1].ext;
-      if (rank_[e2] && (chg_[e1] || rank_[e1] > rank_[e2])) ++node_[e2].ext;
+      const EidT e1 = tri.first;
+      const EidT e2 = tri.second;
+      if (rank_[e1] && (hot_[e2].chg || rank_[e2] > rank_[e1])) IncExt(e1);
+      if (rank_[e2] && (hot_[e1].chg || rank_[e1] > rank_[e2])) IncExt(e2);
     }
-    node_[e].ext = 0;
+    hot_[e].ext = 0;
   }
   // the last processed edge
-  uint32_t le = l_;
+  EidT le = l_;
   // simulate
   for (int32_t k = 0; true; ++k) {
     if (N.empty()) break;
+    if (kStats) CountCandidates(k, N.size());
     // expand the head and tail arrays
     ASSERT(head_.size() == tail_.size());
     while (head_.size() <= static_cast<size_t>(k)) {
-      head_.push_back(UINT32_MAX);
-      tail_.push_back(UINT32_MAX);
+      head_.push_back(kNil);
+      tail_.push_back(kNil);
+    }
+    // the edges with trussness k to be classified as Type-2 or Type-3
+    {
+      std::vector<EidT>& F = buf_.front;
+      F.clear();
+      for (EidT e = node_[le].next; kNil != e && hot_[e].k <= k;
+           e = node_[e].next) {
+        if (0 != hot_[e].ext) F.push_back(e);
+      }
+      Prefetch(F);
     }
     // a stack for DFS
-    std::vector<uint32_t> S;
+    std::vector<EidT>& S = buf_.stack;
+    S.clear();
     // P1 stores the edges removed in the first shrink
-    std::vector<uint32_t> P1;
+    std::vector<EidT>& P1 = buf_.p1;
+    P1.clear();
     // first shrink
     std::copy_if(N.begin(), N.end(), std::back_inserter(S),
-                 [this, k](const uint32_t e){return uint32_t(k) >= s_[e];});
+                 [this, k](const EidT e){return uint32_t(k) >= hot_[e].s;});
     while (!S.empty()) {
-      const uint32_t e = S.back(); S.pop_back();
+      const EidT e = S.back(); S.pop_back();
       // update the information of e
-      std::tie(node_[e].rem, s_[e], ts_[e]) = std::make_tuple(s_[e], 0, 0);
-      chg_[e] = false;  new_[e] = true;
+      std::tie(hot_[e].rem, hot_[e].s, hot_[e].ts) = std::make_tuple(hot_[e].s, 0, 0);
+      hot_[e].chg = false;  hot_[e].fresh = true;
       P1.push_back(e);
       // insert the edge to the order and the list
       OMInsert(e, le);
@@ -340,134 +518,135 @@ void Order::DiBatchInsert(const std::vector<EdgT>& nedges) {
       le = e;
       // find more edges to shrink and upate the ts values of related edges
       // const auto tris = g_.GetTriangles(e);
-      const auto tris = g_.GetCycles(e);
+      const auto& tris = Cycles(e);
       for (const auto tri : tris) {
-        const uint32_t e1 = tri.first;
-        const uint32_t e2 = tri.second;
+        const EidT e1 = tri.first;
+        const EidT e2 = tri.second;
         // update @ts values
-        const int32_t min_k = std::min(k_[e1], k_[e2]);
-        const int32_t ori_k = std::min(min_k, k_[e]);
+        const int32_t min_k = std::min(hot_[e1].k, hot_[e2].k);
+        const int32_t ori_k = std::min(min_k, hot_[e].k);
         const int32_t cur_k = std::min(min_k, k);
-        if (ori_k < k_[e1] && cur_k >= k_[e1]) ++ts_[e1];
-        if (ori_k < k_[e2] && cur_k >= k_[e2]) ++ts_[e2];
-        if (cur_k >= k) ++ts_[e];
+        if (ori_k < hot_[e1].k && cur_k >= hot_[e1].k) ++hot_[e1].ts;
+        if (ori_k < hot_[e2].k && cur_k >= hot_[e2].k) ++hot_[e2].ts;
+        if (cur_k >= k) ++hot_[e].ts;
         // update @s and @ext values
-        if (!chg_[e1] && !(k_[e1] >= k && !new_[e1])) continue;
-        if (!chg_[e2] && !(k_[e2] >= k && !new_[e2])) continue;
-        if (chg_[e1]) {
-          if (static_cast<uint32_t>(k) == --s_[e1]) S.push_back(e1);
-        } else if (chg_[e2] || rank_[e2] > rank_[e1]) {
-          --node_[e1].ext;
+        if (!hot_[e1].chg && !(hot_[e1].k >= k && !hot_[e1].fresh)) continue;
+        if (!hot_[e2].chg && !(hot_[e2].k >= k && !hot_[e2].fresh)) continue;
+        if (hot_[e1].chg) {
+          if (static_cast<uint32_t>(k) == --hot_[e1].s) S.push_back(e1);
+        } else if (hot_[e2].chg || rank_[e2] > rank_[e1]) {
+          --hot_[e1].ext;
         }
-        if (chg_[e2]) {
-          if (static_cast<uint32_t>(k) == --s_[e2]) S.push_back(e2);
-        } else if (chg_[e1] || rank_[e1] > rank_[e2]) {
-          --node_[e2].ext;
+        if (hot_[e2].chg) {
+          if (static_cast<uint32_t>(k) == --hot_[e2].s) S.push_back(e2);
+        } else if (hot_[e1].chg || rank_[e1] > rank_[e2]) {
+          --hot_[e2].ext;
         }
       }
       // update the trussness
-      k_[e] = k;
+      SetK(e, k);
     } {
       // shrink the candidate set
       const auto it = std::copy_if(N.begin(), N.end(), N.begin(),
-          [this](const uint32_t e){return chg_[e];});
+          [this](const EidT e){return hot_[e].chg;});
       N.resize(std::distance(N.begin(), it));
     }
     // update the head and tail
     if (!P1.empty()) {
       head_[k] = P1[0];
-      if (UINT32_MAX == tail_[k]) tail_[k] = P1.back();
+      if (kNil == tail_[k]) tail_[k] = P1.back();
     }
-    // reset the new_ array
-    for (uint32_t e : P1) new_[e] = false;
+    // reset the @fresh flags
+    for (EidT e : P1) hot_[e].fresh = false;
     // scan the edges with trussness k
-    uint32_t next_e = UINT32_MAX;
-    for (uint32_t e = node_[le].next; true; e = next_e) {
-      if (UINT32_MAX == e || k_[e] > k) break;
+    EidT next_e = kNil;
+    for (EidT e = node_[le].next; true; e = next_e) {
+      if (kNil == e || hot_[e].k > k) break;
       next_e = node_[e].next;
       // e* of Type-1
-      if (0 == node_[e].ext) continue;
-      const uint32_t s = node_[e].ext + node_[e].rem;
+      if (0 == hot_[e].ext) continue;
+      const uint32_t s = hot_[e].ext + hot_[e].rem;
       // e* of Type-2
       if (s > static_cast<uint32_t>(k)) {
-        std::tie(s_[e], node_[e].ext) = std::make_tuple(s, 0);
+        hot_[e].s = s;  hot_[e].ext = 0;
         N.push_back(e);
-        chg_[e] = true;
+        hot_[e].chg = true;
         // update the ext values
         // const auto tris = g_.GetTriangles(e);
-        const auto tris = g_.GetCycles(e);
+        const auto& tris = Cycles(e);
         for (const auto tri : tris) {
-          const uint32_t e1 = tri.first;
-          const uint32_t e2 = tri.second;
-          if (rank_[e] < rank_[e1] && (chg_[e2] || rank_[e1] < rank_[e2])) {
-            ++node_[e1].ext;
+          const EidT e1 = tri.first;
+          const EidT e2 = tri.second;
+          if (rank_[e] < rank_[e1] && (hot_[e2].chg || rank_[e1] < rank_[e2])) {
+            IncExt(e1);
           }
-          if (rank_[e] < rank_[e2] && (chg_[e1] || rank_[e2] < rank_[e1])) {
-            ++node_[e2].ext;
+          if (rank_[e] < rank_[e2] && (hot_[e1].chg || rank_[e2] < rank_[e1])) {
+            IncExt(e2);
           }
         }
         // remove the edge from the list and the order
         OMRemove(e);
         ListRemove(e, head_[k], tail_[k]);
       } else { // e* of Type-3
-        std::tie(node_[e].rem, node_[e].ext) = std::make_tuple(s, 0);
+        hot_[e].rem = s;  hot_[e].ext = 0;
         // const auto tris = g_.GetTriangles(e);
-        const auto tris = g_.GetCycles(e);
+        const auto& tris = Cycles(e);
         for (const auto tri : tris) {
-          const uint32_t e1 = tri.first;
-          const uint32_t e2 = tri.second;
-          if (chg_[e1] && (chg_[e2] || rank_[e] < rank_[e2])) {
-            if (static_cast<uint32_t>(k) >= --s_[e1]) S.push_back(e1);
+          const EidT e1 = tri.first;
+          const EidT e2 = tri.second;
+          if (hot_[e1].chg && (hot_[e2].chg || rank_[e] < rank_[e2])) {
+            if (static_cast<uint32_t>(k) >= --hot_[e1].s) S.push_back(e1);
           }
-          if (chg_[e2] && (chg_[e1] || rank_[e] < rank_[e1])) {
-            if (static_cast<uint32_t>(k) >= --s_[e2]) S.push_back(e2);
+          if (hot_[e2].chg && (hot_[e1].chg || rank_[e] < rank_[e1])) {
+            if (static_cast<uint32_t>(k) >= --hot_[e2].s) S.push_back(e2);
           }
         }
         // P3 stores the edges removed from the candidate set
-        std::vector<uint32_t> P3;
+        std::vector<EidT>& P3 = buf_.p3;
+        P3.clear();
         // remove edges from the candidate set
         le = e;
         while (!S.empty()) {
-          const uint32_t ee = S.back(); S.pop_back();
+          const EidT ee = S.back(); S.pop_back();
           // update the status of the edge
-          std::tie(node_[ee].rem, s_[ee]) = std::make_tuple(s_[ee], 0);
-          chg_[ee] = false;
+          std::tie(hot_[ee].rem, hot_[ee].s) = std::make_tuple(hot_[ee].s, 0);
+          hot_[ee].chg = false;
           P3.push_back(ee);
           // list the edge to the list
           OMInsert(ee, le);
           ListInsert(ee, le);
           le = ee;
-          if (k_[ee] != k) {
-            ts_[ee] = 0;
+          if (hot_[ee].k != k) {
+            hot_[ee].ts = 0;
           }
           // const auto tris = g_.GetTriangles(ee);
-          const auto tris = g_.GetCycles(ee);
+          const auto& tris = Cycles(ee);
           for (const auto tri : tris) {
-            const uint32_t e1 = tri.first;
-            const uint32_t e2 = tri.second;
-            if (k_[ee] != k) {
-              const int32_t min_k = std::min(k_[e1], k_[e2]);
-              const int32_t ori_k = std::min(min_k, k_[ee]);
+            const EidT e1 = tri.first;
+            const EidT e2 = tri.second;
+            if (hot_[ee].k != k) {
+              const int32_t min_k = std::min(hot_[e1].k, hot_[e2].k);
+              const int32_t ori_k = std::min(min_k, hot_[ee].k);
               const int32_t cur_k = std::min(min_k, k);
-              if (ori_k < k_[e1] && cur_k >= k_[e1]) ++ts_[e1];
-              if (ori_k < k_[e2] && cur_k >= k_[e2]) ++ts_[e2];
-              if (cur_k >= k) ++ts_[ee];
+              if (ori_k < hot_[e1].k && cur_k >= hot_[e1].k) ++hot_[e1].ts;
+              if (ori_k < hot_[e2].k && cur_k >= hot_[e2].k) ++hot_[e2].ts;
+              if (cur_k >= k) ++hot_[ee].ts;
             }
-            if (!chg_[e1] && rank_[e1] <= rank_[e]) continue;
-            if (!chg_[e2] && rank_[e2] <= rank_[e]) continue;
-            if (chg_[e1]) {
-              if (static_cast<uint32_t>(k) == --s_[e1]) S.push_back(e1);
-            } else if (chg_[e2] || rank_[e1] < rank_[e2]) {
-              --node_[e1].ext;
+            if (!hot_[e1].chg && rank_[e1] <= rank_[e]) continue;
+            if (!hot_[e2].chg && rank_[e2] <= rank_[e]) continue;
+            if (hot_[e1].chg) {
+              if (static_cast<uint32_t>(k) == --hot_[e1].s) S.push_back(e1);
+            } else if (hot_[e2].chg || rank_[e1] < rank_[e2]) {
+              --hot_[e1].ext;
             }
-            if (chg_[e2]) {
-              if (static_cast<uint32_t>(k) == --s_[e2]) S.push_back(e2);
-            } else if (chg_[e1] || rank_[e2] < rank_[e1]) {
-              --node_[e2].ext;
+            if (hot_[e2].chg) {
+              if (static_cast<uint32_t>(k) == --hot_[e2].s) S.push_back(e2);
+            } else if (hot_[e1].chg || rank_[e2] < rank_[e1]) {
+              --hot_[e2].ext;
             }
           }
           // update the trussness
-          k_[ee] = k;
+          SetK(ee, k);
         }
         // update the head and the tail
         if (e == tail_[k] && !P3.empty()) tail_[k] = P3.back();
@@ -475,199 +654,265 @@ void Order::DiBatchInsert(const std::vector<EdgT>& nedges) {
     }
     // shrink N
     const auto it = std::copy_if(N.begin(), N.end(), N.begin(),
-        [this](const uint32_t e){return chg_[e];});
+        [this](const EidT e){return hot_[e].chg;});
     N.resize(std::distance(N.begin(), it));
     // update the last processed edge
-    if (UINT32_MAX != tail_[k]) le = tail_[k];
+    if (kNil != tail_[k]) le = tail_[k];
   }
-  // reset the rank
-  for (uint32_t e = l_; UINT32_MAX != e; e = node_[e].next) {
-    rank_[e] = UINT32_MAX;
+  // reset the rank; the heap is empty, so all the positions are nil
+  ParallelFor(l_ + 1, [this](const size_t e) { rank_[e] = kNil; });
+  ReleaseCycles();
+  if (kStats) {
+    stats_.batch_insert.Count(nedges.size(), tri_cnt_ - tris,
+                              Allocations() - allocs);
   }
 }
 
-void Order::DiRemove(const uint32_t v1, const uint32_t v2) {
-  const uint32_t re = g_.Get(v1, v2);
-  std::vector<uint32_t> S;
+void Order::DiRemove(const VidT v1, const VidT v2) {
+  TraceScope trace("DiRemove");
+  const EidT re = g_.Get(v1, v2);
+  const uint64_t tris0 = tri_cnt_;
+  const uint64_t allocs = Allocations();
+  std::vector<EidT>& S = buf_.stack;
+  S.clear();
+  // the depths of the edges of S in the cascade, if counted
+  std::vector<uint32_t>& D = buf_.depth;
+  D.clear();
+  const auto push = [&S, &D](const EidT e, const uint32_t d) {
+    S.push_back(e);
+    if (kStats) D.push_back(d);
+  };
   // update the @ts and $rem values for other related edges
   // const auto tris = g_.GetTriangles(re);
-  const auto tris = g_.GetCycles(re);
+  const auto& tris = Cycles(re);
   for (const auto tri : tris) {
-    const uint32_t e1 = tri.first;
-    const uint32_t e2 = tri.second;
+    const EidT e1 = tri.first;
+    const EidT e2 = tri.second;
     // update @ts values
-    const int32_t min_k = std::min({k_[re], k_[e1], k_[e2]});
-    if (min_k >= k_[e1] && --ts_[e1] < uint32_t(k_[e1])) S.push_back(e1);
-    if (min_k >= k_[e2] && --ts_[e2] < uint32_t(k_[e2])) S.push_back(e2);
+    const int32_t min_k = std::min({hot_[re].k, hot_[e1].k, hot_[e2].k});
+    if (min_k >= hot_[e1].k && --hot_[e1].ts < uint32_t(hot_[e1].k)) push(e1, 1);
+    if (min_k >= hot_[e2].k && --hot_[e2].ts < uint32_t(hot_[e2].k)) push(e2, 1);
     // update @rem values
-    uint32_t min_e = re;
+    EidT min_e = re;
     if (OMPred(e1, min_e)) min_e = e1;
     if (OMPred(e2, min_e)) min_e = e2;
-    --node_[min_e].rem;
+    --hot_[min_e].rem;
   }
-  // remove the edge
-  g_.DiRemove(re);
+  // remove the edge; SetK needs its endpoints
   OMRemove(re);
-  ListRemove(re, head_[k_[re]], tail_[k_[re]]);
-  k_[re] = -1;
-  ts_[re] = 0;
+  ListRemove(re, head_[hot_[re].k], tail_[hot_[re].k]);
+  SetK(re, -1);
+  g_.DiRemove(re);
+  hot_[re].ts = 0;
   // propagate
+  uint32_t depth = 0;
+  uint64_t cascade = 0;
   while (!S.empty()) {
-    const uint32_t e = S.back(); S.pop_back();
-    std::tie(k_[e], ts_[e]) = std::make_pair(k_[e] - 1, 0);
+    const EidT e = S.back(); S.pop_back();
+    const uint32_t d = kStats ? D.back() : 0;
+    if (kStats) {
+      D.pop_back();
+      depth = std::max(depth, d);
+      ++cascade;
+    }
+    SetK(e, hot_[e].k - 1);
+    hot_[e].ts = 0;
     // the previous edge of @e in the new position of order
-    const uint32_t prev_e = node_[head_[k_[e] + 1]].prev;
+    const EidT prev_e = node_[head_[hot_[e].k + 1]].prev;
     // update @ts and @rem
     // const auto tris = g_.GetTriangles(e);
-    const auto tris = g_.GetCycles(e);
+    const auto& tris = Cycles(e);
     for (const auto tri : tris) {
-      const uint32_t e1 = tri.first;
-      const uint32_t e2 = tri.second;
+      const EidT e1 = tri.first;
+      const EidT e2 = tri.second;
       // the original trussness of the triangle
-      const int32_t ori_k = std::min({k_[e] + 1, k_[e1], k_[e2]});
+      const int32_t ori_k = std::min({hot_[e].k + 1, hot_[e1].k, hot_[e2].k});
       // update the @ts value for @e
-      if (ori_k >= k_[e]) ++ts_[e];
+      if (ori_k >= hot_[e].k) ++hot_[e].ts;
       // update the @ts values for other edges
-      if (ori_k > k_[e]) {
-        if (ori_k == k_[e1] && ts_[e1]-- == uint32_t(k_[e1])) S.push_back(e1);
-        if (ori_k == k_[e2] && ts_[e2]-- == uint32_t(k_[e2])) S.push_back(e2);
+      if (ori_k > hot_[e].k) {
+        if (ori_k == hot_[e1].k && hot_[e1].ts-- == uint32_t(hot_[e1].k)) push(e1, d + 1);
+        if (ori_k == hot_[e2].k && hot_[e2].ts-- == uint32_t(hot_[e2].k)) push(e2, d + 1);
       }
       // update the @rem values
-      uint32_t ori_min_e = e;
+      EidT ori_min_e = e;
       if (OMPred(e1, ori_min_e)) ori_min_e = e1;
       if (OMPred(e2, ori_min_e)) ori_min_e = e2;
       if (e != ori_min_e && OMPred(prev_e, ori_min_e)) {
-        --node_[ori_min_e].rem;
-        ++node_[e].rem;
+        --hot_[ori_min_e].rem;
+        ++hot_[e].rem;
       }
     }
     // remove @e from the order and the list
     OMRemove(e);
-    ListRemove(e, head_[k_[e] + 1], tail_[k_[e] + 1]);
+    ListRemove(e, head_[hot_[e].k + 1], tail_[hot_[e].k + 1]);
     // reinsert @e to the order and the list
     OMInsert(e, prev_e);
     ListInsert(e, prev_e);
-    tail_[k_[e]] = e;
-    if (UINT32_MAX == head_[k_[e]]) head_[k_[e]] = e;
+    tail_[hot_[e].k] = e;
+    if (kNil == head_[hot_[e].k]) head_[hot_[e].k] = e;
   }
+  if (kStats) {
+    stats_.remove.Count(1, tri_cnt_ - tris0, Allocations() - allocs);
+    CountCascade(depth, cascade);
+  }
+  Compact();
 }
 
 void Order::DiBatchRemove(const std::vector<EdgT>& redges) {
+  TraceScope trace("DiBatchRemove", "edges", redges.size());
+  const uint64_t tris0 = tri_cnt_;
+  const uint64_t allocs = Allocations();
   // a stack
-  std::vector<uint32_t> S;
-  // indicators if an edge is in S
-  auto& inS = new_;
-  std::vector<uint32_t> reids;
+  std::vector<EidT>& S = buf_.stack;
+  S.clear();
+  // the depths of the edges of S in the cascade, if counted
+  std::vector<uint32_t>& D = buf_.depth;
+  D.clear();
+  const auto push = [&S, &D](const EidT e, const uint32_t d) {
+    S.push_back(e);
+    if (kStats) D.push_back(d);
+  };
+  // @fresh indicates if an edge is in S
+  std::vector<EidT> reids;
   for (const auto edg : redges) {
-    const uint32_t re = g_.Get(edg.first, edg.second);
+    const EidT re = g_.Get(edg.first, edg.second);
     reids.push_back(re);
-    inS[re] = true;
+    hot_[re].fresh = true;
   }
+  // the triangles of the removed edges in the original graph, enumerated in
+  // parallel; those with an edge removed earlier are skipped below
+  std::vector<std::vector<std::pair<EidT, EidT>>> rtris(reids.size());
+  ParallelFor(reids.size(), [this, &reids, &rtris](const size_t i) {
+    rtris[i] = g_.GetCycles(reids[i]);
+  }, 64);
   // remove the edges from the graph
-  size_t i = 0;
-  for (const auto edg : redges) {
-    const uint32_t re = reids[i++];
-    // const auto tris = g_.GetTriangles(re);
-    const auto tris = g_.GetCycles(re);
+  for (size_t i = 0; i < reids.size(); ++i) {
+    const EidT re = reids[i];
+    auto& tris = rtris[i];
+    tris.erase(std::remove_if(tris.begin(), tris.end(),
+        [this](const std::pair<EidT, EidT>& tri) {
+          return !g_.Contain(tri.first) || !g_.Contain(tri.second);
+        }), tris.end());
+    tri_cnt_ += tris.size();
     for (const auto tri : tris) {
-      const uint32_t e1 = tri.first;
-      const uint32_t e2 = tri.second;
+      const EidT e1 = tri.first;
+      const EidT e2 = tri.second;
       // update @ts values
-      const int32_t min_k = std::min({k_[re], k_[e1], k_[e2]});
-      if (min_k >= k_[e1]) --ts_[e1];
-      if (ts_[e1] < uint32_t(k_[e1]) && !inS[e1]) {
-        S.push_back(e1);
-        inS[e1] = true;
+      const int32_t min_k = std::min({hot_[re].k, hot_[e1].k, hot_[e2].k});
+      if (min_k >= hot_[e1].k) --hot_[e1].ts;
+      if (hot_[e1].ts < uint32_t(hot_[e1].k) && !hot_[e1].fresh) {
+        push(e1, 1);
+        hot_[e1].fresh = true;
       }
-      if (min_k >= k_[e2]) --ts_[e2];
-      if (ts_[e2] < uint32_t(k_[e2]) && !inS[e2]) {
-        S.push_back(e2);
-        inS[e2] = true;
+      if (min_k >= hot_[e2].k) --hot_[e2].ts;
+      if (hot_[e2].ts < uint32_t(hot_[e2].k) && !hot_[e2].fresh) {
+        push(e2, 1);
+        hot_[e2].fresh = true;
       }
       // update @rem values
-      uint32_t min_e = re;
+      EidT min_e = re;
       if (OMPred(e1, min_e)) min_e = e1;
       if (OMPred(e2, min_e)) min_e = e2;
-      --node_[min_e].rem;
+      --hot_[min_e].rem;
     }
-    // remove the edge
-    g_.DiRemove(re);
+    // remove the edge; SetK needs its endpoints
     OMRemove(re);
-    ListRemove(re, head_[k_[re]], tail_[k_[re]]);
-    k_[re] = -1;
-    ts_[re] = 0;
+    ListRemove(re, head_[hot_[re].k], tail_[hot_[re].k]);
+    SetK(re, -1);
+    g_.DiRemove(re);
+    hot_[re].ts = 0;
   }
+  decltype(rtris)().swap(rtris);
+  // @tri_ts stores (ts, tri) pairs; the buffers are reused by all the edges
+  auto& tri_ts = buf_.tri_ts;
+  auto& s_tri_ts = buf_.s_tri_ts;
+  // @bin used for bin sort
+  std::vector<uint32_t>& bin = buf_.bin;
+  // the graph is fixed from now on; whenever edges are pushed onto the
+  // stack, the triangles of all of them are enumerated in parallel before
+  // the next pop, while the edges are still processed one by one in order;
+  // S[0, @fetched) are prefetched
+  size_t fetched = 0;
+  uint32_t depth = 0;
+  uint64_t cascade = 0;
   // update trussnesses
   while (!S.empty()) {
-    const uint32_t e = S.back(); S.pop_back(); inS[e] = false;
-    // @tri_ts stores (ts, tri) pairs
-    std::vector<std::pair<int32_t, std::pair<uint32_t, uint32_t>>> tri_ts;
-    // @bin used for bin sort
-    std::vector<uint32_t> bin(k_[e] + 1, 0);
+    if (fetched < S.size()) {
+      Prefetch(S, fetched);
+      fetched = S.size();
+    }
+    const EidT e = S.back(); S.pop_back(); hot_[e].fresh = false;
+    const uint32_t d = kStats ? D.back() : 0;
+    if (kStats) {
+      D.pop_back();
+      depth = std::max(depth, d);
+      ++cascade;
+    }
+    fetched = S.size();
+    tri_ts.clear();
+    bin.assign(hot_[e].k + 1, 0);
     // enumerate triangles
-    uint32_t v1, v2;
-    std::tie(v1, v2) = g_.Get(e);
-    // const auto tris = g_.GetTriangles(e);
-    const auto tris = g_.GetCycles(e);
+    const auto& tris = TakeCycles(e);
     for (const auto tri : tris) {
-      const uint32_t e1 = tri.first;
-      const uint32_t e2 = tri.second;
-      if (uint32_t(k_[e1]) < ts_[e] || uint32_t(k_[e2]) < ts_[e]) continue;
-      const int32_t min_k = std::min(k_[e1], k_[e2]);
-      if (min_k > k_[e]) continue;
+      const EidT e1 = tri.first;
+      const EidT e2 = tri.second;
+      if (uint32_t(hot_[e1].k) < hot_[e].ts || uint32_t(hot_[e2].k) < hot_[e].ts) continue;
+      const int32_t min_k = std::min(hot_[e1].k, hot_[e2].k);
+      if (min_k > hot_[e].k) continue;
       tri_ts.push_back({min_k, {e1, e2}});
       ++bin[min_k];
     } { // bin sort: initialization
       uint32_t start = 0;
-      for (int32_t i = 0; i <= k_[e]; ++i) {
+      for (int32_t i = 0; i <= hot_[e].k; ++i) {
         const uint32_t cnt = bin[i];
         bin[i] = start;
         start += cnt;
       }
     }
     // bin sort: finalization
-    auto s_tri_ts = tri_ts;
+    s_tri_ts.resize(tri_ts.size());
     for (const auto p : tri_ts) {
       s_tri_ts[bin[p.first]] = p;
       ++bin[p.first];
     }
-    const int32_t ori_k = k_[e];
-    // compute new @k_[e] and @ts_[e]
+    const int32_t ori_k = hot_[e].k;
+    // compute new @hot_[e].k and @hot_[e].ts
     int32_t ptr = s_tri_ts.size() - 1;
-    while (ptr >= 0 && s_tri_ts[ptr].first == k_[e]) --ptr;
-    uint32_t prev_e = tail_[k_[e]];
-    while (uint32_t(k_[e]) > ts_[e]) {
-      --k_[e];
-      while (ptr >= 0 && s_tri_ts[ptr].first >= k_[e]) {
+    while (ptr >= 0 && s_tri_ts[ptr].first == hot_[e].k) --ptr;
+    EidT prev_e = tail_[hot_[e].k];
+    while (uint32_t(hot_[e].k) > hot_[e].ts) {
+      SetK(e, hot_[e].k - 1);
+      while (ptr >= 0 && s_tri_ts[ptr].first >= hot_[e].k) {
         --ptr;
-        ++ts_[e];
+        ++hot_[e].ts;
       }
-      if (UINT32_MAX != head_[k_[e] + 1]) {
-        prev_e = node_[head_[k_[e] + 1]].prev;
+      if (kNil != head_[hot_[e].k + 1]) {
+        prev_e = node_[head_[hot_[e].k + 1]].prev;
       }
     }
     for (int32_t i = s_tri_ts.size() - 1; i > ptr; --i) {
       const int32_t ori_tri_k = std::min(ori_k, s_tri_ts[i].first);
-      const int32_t cur_tri_k = std::min(k_[e], s_tri_ts[i].first);
-      const uint32_t e1 = s_tri_ts[i].second.first;
-      const uint32_t e2 = s_tri_ts[i].second.second;
-      if (ori_tri_k >= k_[e1] && cur_tri_k < k_[e1]) --ts_[e1];
-      if (ts_[e1] < uint32_t(k_[e1]) && !inS[e1]) {
-        S.push_back(e1);
-        inS[e1] = true;
+      const int32_t cur_tri_k = std::min(hot_[e].k, s_tri_ts[i].first);
+      const EidT e1 = s_tri_ts[i].second.first;
+      const EidT e2 = s_tri_ts[i].second.second;
+      if (ori_tri_k >= hot_[e1].k && cur_tri_k < hot_[e1].k) --hot_[e1].ts;
+      if (hot_[e1].ts < uint32_t(hot_[e1].k) && !hot_[e1].fresh) {
+        push(e1, d + 1);
+        hot_[e1].fresh = true;
       }
-      if (ori_tri_k >= k_[e2] && cur_tri_k < k_[e2]) --ts_[e2];
-      if (ts_[e2] < uint32_t(k_[e2]) && !inS[e2]) {
-        S.push_back(e2);
-        inS[e2] = true;
+      if (ori_tri_k >= hot_[e2].k && cur_tri_k < hot_[e2].k) --hot_[e2].ts;
+      if (hot_[e2].ts < uint32_t(hot_[e2].k) && !hot_[e2].fresh) {
+        push(e2, d + 1);
+        hot_[e2].fresh = true;
       }
       // update the @rem values
-      uint32_t min_e = e;
+      EidT min_e = e;
       if (OMPred(e1, min_e)) min_e = e1;
       if (OMPred(e2, min_e)) min_e = e2;
       if (e != min_e && OMPred(prev_e, min_e)) {
-        --node_[min_e].rem;
-        ++node_[e].rem;
+        --hot_[min_e].rem;
+        ++hot_[e].rem;
       }
     }
     // remove @e from the order and the list
@@ -676,232 +921,1102 @@ void Order::DiBatchRemove(const std::vector<EdgT>& redges) {
     // reinsert @e to the order and the list
     OMInsert(e, prev_e);
     ListInsert(e, prev_e);
-    tail_[k_[e]] = e;
-    if (UINT32_MAX == head_[k_[e]]) head_[k_[e]] = e;
+    tail_[hot_[e].k] = e;
+    if (kNil == head_[hot_[e].k]) head_[hot_[e].k] = e;
   }
   // clean
-  for (const uint32_t reid : reids) inS[reid] = false;
+  for (const EidT reid : reids) hot_[reid].fresh = false;
+  ReleaseCycles();
+  if (kStats) {
+    stats_.batch_remove.Count(redges.size(), tri_cnt_ - tris0,
+                              Allocations() - allocs);
+    CountCascade(depth, cascade);
+  }
+  Compact();
 }
 
+void Order::Normalize(const std::vector<UpdT>& batch,
+                      std::vector<EdgT>& redges,
+                      std::vector<EdgT>& nedges) const {
+  // sort the updates by edge, keeping the order of updates on the same edge
+  std::vector<size_t> ord(batch.size());
+  std::iota(ord.begin(), ord.end(), 0);
+  std::stable_sort(ord.begin(), ord.end(), [&batch](size_t i, size_t j) {
+    return batch[i].first < batch[j].first;
+  });
+  // the last update of an edge decides whether it is in the final graph;
+  // duplicates and insert/delete pairs in between cancel out
+  for (size_t i = 0; i < ord.size(); ++i) {
+    if (i + 1 < ord.size() &&
+        batch[ord[i + 1]].first == batch[ord[i]].first) continue;
+    const EdgT edge = batch[ord[i]].first;
+    const bool ins = batch[ord[i]].second;
+    if (ins == Contain(edge.first, edge.second)) continue;
+    (ins ? nedges : redges).push_back(edge);
+  }
+}
 
-void Order::Debug() const {
-  // check @chg_, @new_, @s_
-  for (uint32_t e = 0; e < l_; ++e) {
-    ASSERT(!chg_.at(e) && !new_.at(e));
-    ASSERT(s_.at(e) == 0);
-  }
-  // check the heap
-  ASSERT(1 == hp_tbl_.size());
-  for (uint32_t e = 0; e < l_; ++e) {
-    ASSERT(UINT32_MAX == hp_pos_.at(e));
-  }
-  // auxiliary structure
-  uint32_t seen_cnt = 0;
-  std::vector<bool> seen(l_, false);
-  // check the list, i.e., @node_
-  for (uint32_t e = node_.at(l_).next; UINT32_MAX != e; e = node_.at(e).next) {
-    ASSERT(!seen.at(e));
-    seen.at(e) = true;
-    ++seen_cnt;
-    // the edge indeed exists in the graph
-    ASSERT(g_.Contain(e));
-    // the trussness should be non-decreasing
-    if (UINT32_MAX != node_.at(e).next) {
-      ASSERT(k_.at(e) <= k_.at(node_.at(e).next));
-    }
-    // check the list node
-    if (UINT32_MAX != node_.at(e).next) {
-      ASSERT(node_.at(node_.at(e).next).prev == e);
-    }
-    if (UINT32_MAX != node_.at(e).prev) {
-      ASSERT(node_.at(node_.at(e).prev).next == e);
-    }
-    ASSERT(0 == node_.at(e).ext);
-    // check the remaining support
-    // const auto tris = g_.GetTriangles(e);
-    const auto tris = g_.GetCycles(e);
-    uint32_t check_rem = 0;
-    for (const auto tri : tris) {
-      if (!seen.at(tri.first) && !seen.at(tri.second)) ++check_rem;
+void Order::DiMixedBatch(const std::vector<UpdT>& batch) {
+  TraceScope trace("DiMixedBatch", "updates", batch.size());
+  std::vector<EdgT> redges, nedges;
+  Normalize(batch, redges, nedges);
+  if (!redges.empty()) DiBatchRemove(redges);
+  if (nedges.empty()) return;
+  // DiBatchInsert requires |\Delta G| > 0.01|G|
+  if (nedges.size() > size_t{g_.m()} / 100) {
+    DiBatchInsert(nedges);
+  } else {
+    DiInsert(nedges);
+  }
+}
+
+Plan Order::DiAuto(const std::vector<UpdT>& batch, CostModel& model) {
+  TraceScope trace("DiAuto", "updates", batch.size());
+  std::vector<EdgT> redges, nedges;
+  Normalize(batch, redges, nedges);
+  Plan plan{Strategy::kUnit, Strategy::kUnit,
+            static_cast<EidT>(redges.size()), static_cast<EidT>(nedges.size())};
+  // the total degree of the endpoints of the updated edges
+  const auto degrees = [this](const std::vector<EdgT>& edges) {
+    uint64_t d = 0;
+    for (const auto edge : edges) {
+      d += g_.InDegree(edge.first) + g_.OutDegree(edge.first) +
+           g_.InDegree(edge.second) + g_.OutDegree(edge.second);
     }
-    ASSERT(node_.at(e).rem == check_rem);
-    ASSERT(node_.at(e).rem <= static_cast<uint32_t>(k_.at(e)));
+    return d;
+  };
+  const uint64_t rd = degrees(redges), nd = degrees(nedges);
+  const uint64_t m = g_.m(), w = g_.wedges();
+  if (!redges.empty()) {
+    plan.del = model.Choose(false, redges.size(), m, rd, w);
   }
-  for (uint32_t e = 0; e < l_; ++e) {
-    ASSERT(seen.at(e) || !g_.Contain(e));
+  if (!nedges.empty()) {
+    plan.ins = model.Choose(true, nedges.size(), m - redges.size(), nd, w);
   }
-  ASSERT(g_.m() == seen_cnt);
-  ASSERT(UINT32_MAX == node_.at(l_).prev);
-  // check the head and tail arrays
-  ASSERT(head_.size() == tail_.size());
-  uint32_t check_k_cnt = 0;
-  for (int32_t k = 0; k < static_cast<int32_t>(head_.size()); ++k) {
-    if (UINT32_MAX == head_.at(k)) {
-      ASSERT(UINT32_MAX == tail_.at(k));
+  const auto elapsed = [](const std::chrono::steady_clock::time_point beg) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - beg).count();
+  };
+  // a re-decomposition covers both halves of the batch
+  if ((!redges.empty() && Strategy::kFull == plan.del) ||
+      (!nedges.empty() && Strategy::kFull == plan.ins)) {
+    plan.del = plan.ins = Strategy::kFull;
+    const auto beg = std::chrono::steady_clock::now();
+    Reserve(g_.m() + nedges.size());
+    for (const auto edge : redges) g_.DiRemove(g_.Get(edge.first, edge.second));
+    for (const auto edge : nedges) g_.DiInsert(edge.first, edge.second);
+    Redecompose();
+    Compact();
+    const double ms = elapsed(beg);
+    const double work =
+        CostModel::Work(Strategy::kFull, 0, g_.m(), 0, g_.wedges());
+    if (!redges.empty()) model.Update(false, Strategy::kFull, work, ms);
+    if (!nedges.empty()) model.Update(true, Strategy::kFull, work, ms);
+    return plan;
+  }
+  if (!redges.empty()) {
+    const auto beg = std::chrono::steady_clock::now();
+    if (Strategy::kBatch == plan.del) {
+      DiBatchRemove(redges);
     } else {
-      ASSERT(UINT32_MAX != tail_.at(k));
-      for (uint32_t e = head_.at(k); tail_.at(k) != e; e = node_.at(e).next) {
-        ASSERT(k_.at(e) == k && seen.at(e));
-        ++check_k_cnt;
+      for (const auto edge : redges) DiRemove(edge.first, edge.second);
+    }
+    model.Update(false, plan.del,
+                 CostModel::Work(plan.del, redges.size(), m, rd, w),
+                 elapsed(beg));
+  }
+  if (!nedges.empty()) {
+    const uint64_t nm = g_.m(), nw = g_.wedges();
+    const auto beg = std::chrono::steady_clock::now();
+    if (Strategy::kBatch == plan.ins) {
+      DiBatchInsert(nedges);
+    } else {
+      for (const auto edge : nedges) DiInsert({edge});
+    }
+    model.Update(true, plan.ins,
+                 CostModel::Work(plan.ins, nedges.size(), nm, nd, nw),
+                 elapsed(beg));
+  }
+  return plan;
+}
+
+namespace {
+// the triangle buffer of the calling thread, for the parallel loops that
+// enumerate the triangles of many edges
+std::vector<std::pair<EidT, EidT>>& ThreadCycles() {
+  thread_local std::vector<std::pair<EidT, EidT>> tris;
+  return tris;
+}
+}  // namespace
+
+void Order::Redecompose() {
+  TraceScope trace("Redecompose", "edges", g_.m());
+  const uint64_t tris = tri_cnt_;
+  const uint64_t allocs = Allocations();
+  // reset the records; the trussness of an unused ID is -1
+  for (auto& h : hot_) {
+    h = EdgeHot();
+    h.k = -1;
+  }
+  // 1. count the supports in parallel; the graph is read-only here
+  std::vector<uint32_t> sup(l_, 0);
+  ParallelFor(l_, [this, &sup](const size_t e) {
+    if (!g_.Contain(e)) return;
+    auto& cycles = ThreadCycles();
+    g_.GetCycles(e, cycles);
+    sup[e] = cycles.size();
+  });
+  // counting, peeling and computing @ts each enumerate all the triangles
+  tri_cnt_ += 3 * std::accumulate(sup.cbegin(), sup.cend(), uint64_t{0});
+  // 2. sort the edges by their supports
+  const EidT m = g_.m();
+  const uint32_t maxs = *std::max_element(sup.cbegin(), sup.cend());
+  std::vector<EidT> bin(maxs + 1, 0);
+  for (EidT e = 0; e < l_; ++e) {
+    if (g_.Contain(e)) ++bin[sup[e]];
+  }
+  for (EidT s = 0, start = 0; s <= maxs; ++s) {
+    start += bin[s];
+    bin[s] = start - bin[s];
+  }
+  std::vector<EidT> ord(m), pos(l_);
+  for (EidT e = 0; e < l_; ++e) {
+    if (!g_.Contain(e)) continue;
+    pos[e] = bin[sup[e]]++;
+    ord[pos[e]] = e;
+  }
+  std::rotate(bin.rbegin(), bin.rbegin() + 1, bin.rend());
+  bin[0] = 0;
+  // 3. peel; the peeling order is the new order of the edges, and @rem counts
+  // the triangles whose other two edges are peeled later
+  std::vector<bool> removed(l_, false);
+  uint32_t c = 0;
+  for (EidT i = 0; i < m; ++i) {
+    const EidT e = ord[i];
+    c = std::max(c, sup[e]);
+    ++bin[sup[e]];
+    removed[e] = true;
+    hot_[e].k = static_cast<int32_t>(c);
+    g_.GetCycles(e, buf_.tris);
+    for (const auto tri : buf_.tris) {
+      if (removed[tri.first] || removed[tri.second]) continue;
+      ++hot_[e].rem;
+      for (const EidT x : {tri.first, tri.second}) {
+        if (sup[x] <= c) continue;
+        const EidT px = pos[x];
+        const EidT py = bin[sup[x]];
+        if (px != py) {
+          const EidT y = ord[py];
+          ord[px] = y;
+          pos[y] = px;
+          ord[py] = x;
+          pos[x] = py;
+        }
+        ++bin[sup[x]];
+        --sup[x];
       }
-      ASSERT(k_.at(tail_.at(k)) == k && seen.at(tail_.at(k)));
-      ++check_k_cnt;
-      if (l_ != node_.at(head_.at(k)).prev) {
-        ASSERT(k_.at(node_.at(head_.at(k)).prev) < k);
+    }
+  }
+  // 4. count the triangle supports in parallel
+  ParallelFor(l_, [this](const size_t e) {
+    if (!g_.Contain(e)) return;
+    auto& cycles = ThreadCycles();
+    g_.GetCycles(e, cycles);
+    uint32_t ts = 0;
+    for (const auto tri : cycles) {
+      if (hot_[tri.first].k >= hot_[e].k && hot_[tri.second].k >= hot_[e].k) {
+        ++ts;
+      }
+    }
+    hot_[e].ts = ts;
+  });
+  // 5. rebuild the list and the order maintenance structure
+  ListLoad(ord);
+  OMLoad();
+  comm_.clear();
+  VertexLoad();
+  if (nullptr != sky_) Attach(sky_, layer_);
+  if (kStats) {
+    stats_.redecompose.Count(g_.m(), tri_cnt_ - tris, Allocations() - allocs);
+  }
+  if (track_) touched_all_ = true;
+}
+
+void Order::Debug() const {
+  ASSERT_MSG(0 == Verify("", VerifyMode::kFull), "inconsistent structures");
+  printf("Debug completed.\n");
+}
+
+void Order::Check(const std::string& fn) const {
+  ASSERT_MSG(0 == Verify(fn, VerifyMode::kFull), "wrong answer");
+}
+
+namespace {
+// the mismatches found by Order::Verify; of them, the @keep ones with the
+// least keys are kept, so that the report does not depend on the timing of
+// the threads
+class Mismatches final {
+ public:
+  explicit Mismatches(const size_t keep) : keep_(keep) {}
+  void Add(const uint64_t key, const char* fmt, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof buf, fmt, args);
+    va_end(args);
+    std::lock_guard<std::mutex> lock(mu_);
+    ++count_;
+    if (0 == keep_) return;
+    if (kept_.size() == keep_) {
+      if (key >= kept_.front().first) return;
+      std::pop_heap(kept_.begin(), kept_.end());
+      kept_.pop_back();
+    }
+    kept_.push_back({key, buf});
+    std::push_heap(kept_.begin(), kept_.end());
+  }
+  uint64_t count() const { return count_; }
+  void Print() const {
+    auto sorted = kept_;
+    std::sort(sorted.begin(), sorted.end());
+    for (const auto& m : sorted) printf("  %s\n", m.second.c_str());
+    if (count_ > sorted.size()) {
+      printf("  ... and %" PRIu64 " more\n", count_ - sorted.size());
+    }
+  }
+
+ private:
+  const size_t keep_;
+  std::mutex mu_;
+  uint64_t count_ = 0;
+  std::vector<std::pair<uint64_t, std::string>> kept_;
+};
+// the keys of the mismatches: the section of the check, then the position
+uint64_t MismatchKey(const uint64_t section, const uint64_t pos) {
+  return section << 48 | pos;
+}
+}  // namespace
+
+const char* VerifyModeName(const VerifyMode mode) {
+  switch (mode) {
+    case VerifyMode::kOff: return "off";
+    case VerifyMode::kSampled: return "sampled";
+    case VerifyMode::kIncremental: return "incremental";
+    default: return "full";
+  }
+}
+
+VerifyMode VerifyModeFromEnv() {
+  const char* env = std::getenv("TRUSS_VERIFY");
+  if (nullptr == env) return VerifyMode::kFull;
+  for (const VerifyMode mode :
+       {VerifyMode::kOff, VerifyMode::kSampled, VerifyMode::kFull,
+        VerifyMode::kIncremental}) {
+    if (std::string(VerifyModeName(mode)) == env) return mode;
+  }
+  ASSERT_MSG(false,
+             "TRUSS_VERIFY should be off, sampled, full or incremental");
+  return VerifyMode::kFull;
+}
+
+uint64_t Order::Verify(const std::string& fn, const VerifyMode mode,
+                       const size_t report) const {
+  if (VerifyMode::kOff == mode) return 0;
+  TraceScope trace("Verify");
+  const EidT stride = VerifyMode::kSampled == mode ? kVerifyStride : 1;
+  Mismatches bad(report);
+  // 1. the per-edge flags and the heap, which are clear between updates
+  for (EidT e = 0; e < l_; ++e) {
+    if (hot_[e].chg || hot_[e].fresh || 0 != hot_[e].s) {
+      bad.Add(MismatchKey(1, e), "edge #%" PRIu64 ": flags not cleared "
+              "(chg %u, fresh %u, s %u)", uint64_t{e}, hot_[e].chg,
+              hot_[e].fresh, hot_[e].s);
+    }
+    if (kNil != hp_pos_[e]) {
+      bad.Add(MismatchKey(1, e), "edge #%" PRIu64 ": left in the heap",
+              uint64_t{e});
+    }
+  }
+  if (1 != hp_tbl_.size()) {
+    bad.Add(MismatchKey(1, l_), "heap of size %zu", hp_tbl_.size() - 1);
+  }
+  // 2. the list: the live edges once each, with links in both directions
+  // and non-decreasing trussness; pos[e] is the position of e in it
+  std::vector<EidT> list;
+  std::vector<EidT> pos(l_, kNil);
+  for (EidT e = node_[l_].next; kNil != e; e = node_[e].next) {
+    if (e >= l_ || kNil != pos[e]) {
+      bad.Add(MismatchKey(2, list.size()), "list broken at position %zu by "
+              "edge #%" PRIu64, list.size(), uint64_t{e});
+      break;
+    }
+    pos[e] = list.size();
+    list.push_back(e);
+    if (!g_.Contain(e)) {
+      bad.Add(MismatchKey(2, pos[e]), "edge #%" PRIu64 " listed but not in "
+              "the graph", uint64_t{e});
+      continue;
+    }
+    const EidT next = node_[e].next;
+    if (kNil != next && (next >= l_ || node_[next].prev != e ||
+                         hot_[e].k > hot_[next].k)) {
+      bad.Add(MismatchKey(2, pos[e]), "edge #%" PRIu64 " (k %d) and its "
+              "successor #%" PRIu64 " out of order or unlinked", uint64_t{e},
+              hot_[e].k, uint64_t{next});
+    }
+    if (0 != hot_[e].ext || hot_[e].rem > static_cast<uint32_t>(hot_[e].k)) {
+      bad.Add(MismatchKey(2, pos[e]), "edge #%" PRIu64 ": ext %u, rem %u "
+              "above k %d", uint64_t{e}, hot_[e].ext, hot_[e].rem,
+              hot_[e].k);
+    }
+  }
+  if (kNil != node_[l_].prev) {
+    bad.Add(MismatchKey(2, l_), "the head of the list has a predecessor");
+  }
+  for (EidT e = 0; e < l_; ++e) {
+    if (kNil == pos[e] && g_.Contain(e)) {
+      bad.Add(MismatchKey(3, e), "edge #%" PRIu64 " in the graph but not "
+              "listed", uint64_t{e});
+    }
+    if (kNil == pos[e] && 0 != hot_[e].ts) {
+      bad.Add(MismatchKey(3, e), "unused edge #%" PRIu64 " with ts %u",
+              uint64_t{e}, hot_[e].ts);
+    }
+  }
+  if (g_.m() != list.size()) {
+    bad.Add(MismatchKey(3, l_), "%zu edges listed, %" PRIu64 " in the graph",
+            list.size(), uint64_t{g_.m()});
+  }
+  // 3. the levels: head_[k] .. tail_[k] are the edges with trussness k
+  EidT leveled = 0;
+  for (int32_t k = 0; k < static_cast<int32_t>(head_.size()); ++k) {
+    const EidT h = head_[k], t = k < int32_t(tail_.size()) ? tail_[k] : kNil;
+    if (kNil == h || kNil == t) {
+      if (h != t) bad.Add(MismatchKey(4, k), "level %d half empty", k);
+      continue;
+    }
+    EidT e = h;
+    for (; kNil != e && e < l_ && kNil != pos[e] && hot_[e].k == k;
+         e = node_[e].next) {
+      ++leveled;
+      if (t == e) break;
+    }
+    if (t != e ||
+        (l_ != node_[h].prev && hot_[node_[h].prev].k >= k) ||
+        (kNil != node_[t].next && hot_[node_[t].next].k <= k)) {
+      bad.Add(MismatchKey(4, k), "level %d: head #%" PRIu64 " and tail #%"
+              PRIu64 " do not bound its edges", k, uint64_t{h}, uint64_t{t});
+    }
+  }
+  if (head_.size() != tail_.size() || g_.m() != leveled) {
+    bad.Add(MismatchKey(4, head_.size()), "%" PRIu64 " edges in the levels, "
+            "%" PRIu64 " in the graph", uint64_t{leveled}, uint64_t{g_.m()});
+  }
+  // 4. the order maintenance: increasing labels along the list, group sizes
+  // and the used and free group lists
+  EidT groups = 0;
+  for (EidT i = 0; i < list.size(); ++i) {
+    const EidT prev = 0 == i ? l_ : list[i - 1];
+    if (!OMPred(prev, list[i])) {
+      bad.Add(MismatchKey(5, i), "edge #%" PRIu64 " not after its "
+              "predecessor in the order", uint64_t{list[i]});
+    }
+  }
+  for (EidT i = 0; i <= list.size(); ) {
+    const EidT grp = hot_[0 == i ? l_ : list[i - 1]].grp;
+    uint32_t cnt = 0;
+    for (; i <= list.size() && hot_[0 == i ? l_ : list[i - 1]].grp == grp;
+         ++i) {
+      ++cnt;
+    }
+    ++groups;
+    if (om_cnt_[grp] != cnt) {
+      bad.Add(MismatchKey(5, i), "group %" PRIu64 " counts %u edges, "
+              "holds %u", uint64_t{grp}, om_cnt_[grp], cnt);
+    }
+  }
+  EidT free_groups = 0, used_groups = 0;
+  for (EidT g = om_avail_; kNil != g && free_groups <= l_ + 2;
+       g = om_nodes_[g].next, ++free_groups) {
+    const EidT next = om_nodes_[g].next;
+    if (0 != om_cnt_[g] || (kNil != next && om_nodes_[next].prev != g)) {
+      bad.Add(MismatchKey(6, g), "free group %" PRIu64 " in use or "
+              "unlinked", uint64_t{g});
+    }
+  }
+  for (EidT g = 0; kNil != g && used_groups <= l_ + 2;
+       g = om_nodes_[g].next, ++used_groups) {
+    const EidT next = om_nodes_[g].next;
+    if ((l_ + 1 != g ? 0 == om_cnt_[g] : 0 != om_cnt_[g]) ||
+        om_cnt_[g] > om_grp_ub_ ||
+        (kNil != next && (om_nodes_[next].tag <= om_nodes_[g].tag ||
+                          om_nodes_[next].prev != g))) {
+      bad.Add(MismatchKey(6, g), "used group %" PRIu64 " of %u edges "
+              "misplaced", uint64_t{g}, om_cnt_[g]);
+    }
+  }
+  if (kNil == om_avail_ || kNil != om_nodes_[om_avail_].prev ||
+      kNil != om_nodes_[0].prev || used_groups != groups + 1 ||
+      free_groups + used_groups != l_ + 2) {
+    bad.Add(MismatchKey(6, l_ + 2), "%" PRIu64 " used and %" PRIu64
+            " free groups for %" PRIu64 " in the list", uint64_t{used_groups},
+            uint64_t{free_groups}, uint64_t{groups});
+  }
+  // 5. the triangle support and the remaining support, in parallel; the
+  // remaining support counts the triangles whose other edges come later
+  if (0 == bad.count()) {
+    ParallelFor(list.size(), [&](const size_t i) {
+      if (0 != i % stride) return;
+      const EidT e = list[i];
+      auto& cycles = ThreadCycles();
+      g_.GetCycles(e, cycles);
+      uint32_t ts = 0, rem = 0;
+      for (const auto tri : cycles) {
+        const EidT e1 = tri.first, e2 = tri.second;
+        if (hot_[e1].k >= hot_[e].k && hot_[e2].k >= hot_[e].k) ++ts;
+        if (pos[e1] > i && pos[e2] > i) ++rem;
       }
-      if (UINT32_MAX != node_.at(tail_.at(k)).next) {
-        ASSERT(k_.at(node_.at(tail_.at(k)).next) > k);
+      if (ts != hot_[e].ts || rem != hot_[e].rem) {
+        const EdgT uv = g_.Get(e);
+        bad.Add(MismatchKey(7, i), "edge (%" PRIu64 ", %" PRIu64 ") #%"
+                PRIu64 " at position %zu, k %d: ts %u, expected %u; rem %u, "
+                "expected %u", uint64_t{uv.first}, uint64_t{uv.second},
+                uint64_t{e}, i, hot_[e].k, hot_[e].ts, ts, hot_[e].rem, rem);
       }
+    }, 64);
+  }
+  // 6. the trussness against the index, streamed in chunks of records that
+  // are looked up in parallel; in full, every edge should be matched once
+  if (!fn.empty()) {
+    std::ifstream in(fn, std::ios::binary);
+    ASSERT_MSG(in.is_open(), "cannot open the ground truth");
+    VidT n = 0;
+    EidT m = 0;
+    in.read(reinterpret_cast<char*>(&n), sizeof n)
+      .read(reinterpret_cast<char*>(&m), sizeof m);
+    if (n_ != n || g_.m() != m) {
+      bad.Add(MismatchKey(8, 0), "the ground truth has %" PRIu64 " vertices "
+              "and %" PRIu64 " edges, the order %" PRIu64 " and %" PRIu64,
+              uint64_t{n}, uint64_t{m}, uint64_t{n_}, uint64_t{g_.m()});
+    }
+    std::vector<std::atomic<uint8_t>> matched(1 == stride ? l_ : 0);
+    const EidT kChunk = EidT{1} << 16;
+    std::vector<EidT> buf;
+    for (EidT beg = 0; beg < m; beg += kChunk) {
+      const EidT cnt = std::min(kChunk, m - beg);
+      buf.resize(size_t{cnt} * 5);
+      in.read(reinterpret_cast<char*>(buf.data()), buf.size() * sizeof(EidT));
+      ASSERT_MSG(!in.fail(), "truncated ground truth");
+      ParallelFor(cnt, [&](const size_t i) {
+        if (0 != (beg + i) % stride) return;
+        const VidT v1 = buf[i * 5], v2 = buf[i * 5 + 1];
+        const int32_t k = static_cast<int32_t>(buf[i * 5 + 2]);
+        const EidT e = g_.Find(v1, v2);
+        if (kNil == e) {
+          bad.Add(MismatchKey(9, beg + i), "record %" PRIu64 ": edge (%"
+                  PRIu64 ", %" PRIu64 ") with k %d missing", uint64_t{beg + i},
+                  uint64_t{v1}, uint64_t{v2}, k);
+        } else if (hot_[e].k != k) {
+          bad.Add(MismatchKey(9, beg + i), "record %" PRIu64 ": edge (%"
+                  PRIu64 ", %" PRIu64 ") #%" PRIu64 " has k %d, expected %d "
+                  "(ts %u, rem %u, degrees %zu+%zu and %zu+%zu)",
+                  uint64_t{beg + i}, uint64_t{v1}, uint64_t{v2}, uint64_t{e},
+                  hot_[e].k, k, hot_[e].ts, hot_[e].rem, g_.InDegree(v1),
+                  g_.OutDegree(v1), g_.InDegree(v2), g_.OutDegree(v2));
+        } else if (!matched.empty() && matched[e]++) {
+          bad.Add(MismatchKey(9, beg + i), "record %" PRIu64 ": edge (%"
+                  PRIu64 ", %" PRIu64 ") repeated", uint64_t{beg + i},
+                  uint64_t{v1}, uint64_t{v2});
+        }
+      });
     }
   }
-  ASSERT(g_.m() == check_k_cnt);
-  // check the order
-  for (uint32_t e = l_; UINT32_MAX != e; e = node_.at(e).next) {
-    if (UINT32_MAX != node_.at(e).next) {
-      ASSERT(OMPred(e, node_.at(e).next));
-    }
-  }
-  uint32_t check_grp_num = 0;
-  for (uint32_t e = l_; UINT32_MAX != e; ) {
-    const uint32_t grp = om_grp_.at(e);
-    uint32_t check_cnt = 0;
-    for (; UINT32_MAX != e; e = node_.at(e).next) {
-      if (grp != om_grp_.at(e)) break;
-      ++check_cnt;
-    }
-    ++check_grp_num;
-    ASSERT(om_cnt_.at(grp) == check_cnt);
-  }
-  // check the free groups
-  uint32_t check_free_grp_num = 0;
-  for (uint32_t g = om_avail_; UINT32_MAX != g; g = om_nodes_.at(g).next) {
-    ++check_free_grp_num;
-    ASSERT(0 == om_cnt_.at(g));
-    if (UINT32_MAX != om_nodes_.at(g).next) {
-      ASSERT(om_nodes_.at(om_nodes_.at(g).next).prev == g);
-    }
-  }
-  ASSERT(UINT32_MAX != om_avail_ && UINT32_MAX == om_nodes_.at(om_avail_).prev);
-  // check the used groups
-  uint32_t check_used_grp_num = 0;
-  for (uint32_t g = 0; UINT32_MAX != g; g = om_nodes_.at(g).next) {
-    ++check_used_grp_num;
-    ASSERT(l_ + 1 != g ? 0 < om_cnt_.at(g) : 0 == om_cnt_.at(g));
-    ASSERT(om_cnt_.at(g) <= om_grp_ub_);
-    if (UINT32_MAX != om_nodes_.at(g).next) {
-      ASSERT(om_nodes_.at(om_nodes_.at(g).next).tag > om_nodes_.at(g).tag);
-      ASSERT(om_nodes_.at(om_nodes_.at(g).next).prev == g);
-    }
-  }
-  ASSERT(UINT32_MAX == om_nodes_.at(0).prev);
-  // sum of the # of free groups and the # of used groups
-  ASSERT(check_used_grp_num == check_grp_num + 1);
-  ASSERT(check_free_grp_num + check_used_grp_num == l_ + 2);
-  // check the ts values
-  for (uint32_t e = node_.at(l_).next; UINT32_MAX != e; e = node_.at(e).next) {
-    uint32_t check_ts = 0;
-    // const auto tris = g_.GetTriangles(e);
-    const auto tris = g_.GetCycles(e);
-    for (const auto tri : tris) {
-      const uint32_t e1 = tri.first;
-      const uint32_t e2 = tri.second;
-      if (k_.at(e1) >= k_.at(e) && k_.at(e2) >= k_.at(e)) {
-        ++check_ts;
+  if (0 != bad.count()) {
+    printf("%" PRIu64 " mismatches (%s verification):\n", bad.count(),
+           VerifyModeName(mode));
+    bad.Print();
+  }
+  return bad.count();
+}
+
+void Order::Track(const bool on) {
+  track_ = on;
+  touched_all_ = false;
+  decltype(touched_)().swap(touched_);
+}
+
+uint64_t Order::VerifyTouched(const size_t report) {
+  if (touched_all_) {
+    touched_all_ = false;
+    touched_.clear();
+    return Verify("", VerifyMode::kFull, report);
+  }
+  TraceScope trace("VerifyTouched");
+  // the touched edges, and the edges in triangles with them, whose supports
+  // depend on their trussness and their positions
+  std::vector<EidT> es;
+  es.swap(touched_);
+  std::sort(es.begin(), es.end());
+  es.erase(std::unique(es.begin(), es.end()), es.end());
+  const size_t touched = es.size();
+  for (size_t i = 0; i < touched; ++i) {
+    if (es[i] >= l_ || !g_.Contain(es[i])) continue;
+    for (const auto tri : g_.GetCycles(es[i])) {
+      es.push_back(tri.first);
+      es.push_back(tri.second);
+    }
+  }
+  std::sort(es.begin(), es.end());
+  es.erase(std::unique(es.begin(), es.end()), es.end());
+  Mismatches bad(report);
+  if (1 != hp_tbl_.size()) {
+    bad.Add(MismatchKey(1, l_), "heap of size %zu", hp_tbl_.size() - 1);
+  }
+  ParallelFor(es.size(), [&](const size_t i) {
+    const EidT e = es[i];
+    if (e >= l_) {
+      bad.Add(MismatchKey(1, e), "touched edge #%" PRIu64 " out of range",
+              uint64_t{e});
+      return;
+    }
+    const EdgeHot& h = hot_[e];
+    if (h.chg || h.fresh || 0 != h.s || kNil != hp_pos_[e]) {
+      bad.Add(MismatchKey(1, e), "edge #%" PRIu64 ": flags not cleared "
+              "(chg %u, fresh %u, s %u) or left in the heap", uint64_t{e},
+              h.chg, h.fresh, h.s);
+    }
+    const EidT prev = node_[e].prev, next = node_[e].next;
+    if (!g_.Contain(e)) {
+      if (-1 != h.k || 0 != h.ts || kNil != prev || kNil != next) {
+        bad.Add(MismatchKey(3, e), "removed edge #%" PRIu64 " with k %d and "
+                "ts %u, or still listed", uint64_t{e}, h.k, h.ts);
       }
+      return;
+    }
+    // its links, its place in the order and its level
+    if (kNil == prev || prev > l_ || node_[prev].next != e ||
+        (kNil != next && (next >= l_ || node_[next].prev != e))) {
+      bad.Add(MismatchKey(2, e), "edge #%" PRIu64 " unlinked", uint64_t{e});
+      return;
+    }
+    if ((l_ != prev && hot_[prev].k > h.k) ||
+        (kNil != next && h.k > hot_[next].k) || !OMPred(prev, e) ||
+        (kNil != next && !OMPred(e, next))) {
+      bad.Add(MismatchKey(2, e), "edge #%" PRIu64 " (k %d) out of order "
+              "with its neighbors in the list", uint64_t{e}, h.k);
+    }
+    if (0 != h.ext || h.rem > static_cast<uint32_t>(h.k)) {
+      bad.Add(MismatchKey(2, e), "edge #%" PRIu64 ": ext %u, rem %u above "
+              "k %d", uint64_t{e}, h.ext, h.rem, h.k);
+    }
+    if (h.k < 0 || h.k >= static_cast<int32_t>(head_.size()) ||
+        ((l_ == prev || hot_[prev].k < h.k) != (head_[h.k] == e)) ||
+        ((kNil == next || hot_[next].k > h.k) != (tail_[h.k] == e))) {
+      bad.Add(MismatchKey(4, e), "edge #%" PRIu64 ": level %d bounded "
+              "wrongly", uint64_t{e}, h.k);
+    }
+    // the size of its group, whose edges are adjacent in the list
+    uint32_t cnt = 1;
+    for (EidT x = prev; kNil != x && hot_[x].grp == h.grp &&
+                        cnt <= om_grp_ub_; x = node_[x].prev) {
+      ++cnt;
+    }
+    for (EidT x = next; kNil != x && hot_[x].grp == h.grp &&
+                        cnt <= om_grp_ub_; x = node_[x].next) {
+      ++cnt;
     }
-    ASSERT(check_ts == ts_.at(e));
+    if (om_cnt_[h.grp] != cnt) {
+      bad.Add(MismatchKey(5, e), "group %" PRIu64 " of edge #%" PRIu64
+              " counts %u edges, holds %u", uint64_t{h.grp}, uint64_t{e},
+              om_cnt_[h.grp], cnt);
+    }
+    // its supports
+    auto& cycles = ThreadCycles();
+    g_.GetCycles(e, cycles);
+    uint32_t ts = 0, rem = 0;
+    for (const auto tri : cycles) {
+      const EidT e1 = tri.first, e2 = tri.second;
+      if (hot_[e1].k >= h.k && hot_[e2].k >= h.k) ++ts;
+      if (OMPred(e, e1) && OMPred(e, e2)) ++rem;
+    }
+    if (ts != h.ts || rem != h.rem) {
+      const EdgT uv = g_.Get(e);
+      bad.Add(MismatchKey(7, e), "edge (%" PRIu64 ", %" PRIu64 ") #%" PRIu64
+              ", k %d: ts %u, expected %u; rem %u, expected %u",
+              uint64_t{uv.first}, uint64_t{uv.second}, uint64_t{e}, h.k,
+              h.ts, ts, h.rem, rem);
+    }
+  }, 64);
+  if (0 != bad.count()) {
+    printf("%" PRIu64 " mismatches among %zu touched edges (incremental "
+           "verification):\n", bad.count(), es.size());
+    bad.Print();
   }
-  for (uint32_t e = 0; e < l_; ++e) {
-    ASSERT(!seen.at(e) ? 0 == ts_.at(e) : true);
+  return bad.count();
+}
+
+IncrementalCheck::IncrementalCheck(Order& tm, const VerifyMode mode)
+    : tm_(tm), on_(VerifyMode::kIncremental == mode),
+      period_([] {
+        const char* env = std::getenv("TRUSS_VERIFY_PERIOD");
+        return nullptr == env ? 1024 : strtoull(env, nullptr, 10);
+      }()) {
+  if (on_) tm_.Track(true);
+}
+
+IncrementalCheck::~IncrementalCheck() {
+  if (!on_) return;
+  Reap(true);
+  tm_.Track(false);
+}
+
+void IncrementalCheck::Updated() {
+  if (!on_) return;
+  ASSERT_MSG(0 == tm_.VerifyTouched(), "inconsistent structures");
+  Reap(false);
+  if (0 == period_ || 0 != ++updates_ % period_ || -1 != child_) return;
+  // the child checks the image of the order at the fork and leaves without
+  // the exit handlers of the parent, e.g. the writing of the trace; the
+  // buffered output is flushed first, so that it is not written twice
+  fflush(stdout);
+  const pid_t pid = fork();
+  if (0 == pid) {
+    const uint64_t bad = tm_.Verify("", VerifyMode::kFull);
+    fflush(stdout);
+    _exit(0 == bad ? 0 : 1);
   }
-  printf("Debug completed.\n");
+  ASSERT_MSG(pid > 0, "cannot fork the background check");
+  child_ = pid;
 }
 
+void IncrementalCheck::Reap(const bool block) {
+  if (-1 == child_) return;
+  int status = 0;
+  const pid_t pid = waitpid(child_, &status, block ? 0 : WNOHANG);
+  if (0 == pid) return;
+  child_ = -1;
+  ASSERT_MSG(pid > 0 && WIFEXITED(status) && 0 == WEXITSTATUS(status),
+             "the background check found inconsistent structures");
+}
 
-void Order::Check(const std::string& fn) const {
-  // load the ground truth
-  std::ifstream ansfile(fn, std::ios::binary);
-  // read the # of vertices and the # of edges
-  uint32_t n = -1, m = -1;
-  ansfile.read(reinterpret_cast<char*>(&n), sizeof n)
-         .read(reinterpret_cast<char*>(&m), sizeof m);
-  ASSERT(g_.m() == m && n_ == n);
-  // read the edges and their truss numbers
-  std::vector<std::pair<EdgT, int32_t>> answer;
-  for (uint32_t e = 0; e < m; ++e) {
-    uint32_t buf[5];
-    ansfile.read(reinterpret_cast<char*>(buf), sizeof buf);
-    uint32_t v1 = buf[0];
-    uint32_t v2 = buf[1];
-    ASSERT(v1 < n && v2 < n);
-    if (v1 > v2) std::swap(v1, v2);
-    answer.push_back({{v1, v2}, buf[2]});
-  }
-  ansfile.close();
-  // get the results computed by ours
-  std::vector<std::pair<EdgT, int32_t>> result;
-  for (uint32_t e = node_.at(l_).next; UINT32_MAX != e; e = node_.at(e).next) {
-    const auto info = g_.Get(e);
-    uint32_t v1 = info.first;
-    uint32_t v2 = info.second;
-    if (v1 > v2) std::swap(v1, v2);
-    result.push_back({{v1, v2}, k_.at(e)});
-  }
-  // compare
-  std::sort(answer.begin(), answer.end());
-  std::sort(result.begin(), result.end());
-  ASSERT_MSG(answer == result, "wrong answer");
+MemoryT Order::Memory() const {
+  MemoryT mem = g_.Memory();
+  uint64_t comm = Bytes(comm_);
+  for (const auto& c : comm_) {
+    comm += Bytes(c.parent) + Bytes(c.size) + Bytes(c.pending);
+  }
+  mem.insert(mem.end(), {
+      {"hot", Bytes(hot_)},
+      {"node", Bytes(node_)},
+      {"head_tail", Bytes(head_) + Bytes(tail_)},
+      {"om", Bytes(om_nodes_) + Bytes(om_cnt_)},
+      {"heap", Bytes(hp_tbl_) + Bytes(hp_pos_)},
+      {"vertex", Bytes(vhist_)},
+      {"community", comm},
+      {"buffers", Bytes(buf_.cand) + Bytes(buf_.stack) + Bytes(buf_.depth) +
+                  Bytes(buf_.p1) + Bytes(buf_.p3) + Bytes(buf_.front) +
+                  Bytes(buf_.tris) + Bytes(buf_.tri_ts) +
+                  Bytes(buf_.s_tri_ts) + Bytes(buf_.bin)}});
+  return mem;
+}
+
+void Order::CountCandidates(const int32_t k, const size_t size) {
+  if (stats_.cand.size() <= size_t(k)) {
+    stats_.cand.resize(k + 1);
+    stats_.cand_max.resize(k + 1);
+  }
+  stats_.cand[k] += size;
+  stats_.cand_max[k] = std::max<uint64_t>(stats_.cand_max[k], size);
+}
+void Order::CountCascade(const uint32_t depth, const uint64_t edges) {
+  if (stats_.depth.size() <= depth) stats_.depth.resize(depth + 1);
+  ++stats_.depth[depth];
+  stats_.cascade += edges;
+}
+namespace {
+void AppendJson(std::string& out, const char* key, const uint64_t val) {
+  char buf[64];
+  snprintf(buf, sizeof buf, "\"%s\": %" PRIu64, key, val);
+  out += buf;
+}
+void AppendJson(std::string& out, const char* key,
+                const std::vector<uint64_t>& vals) {
+  out += '"';
+  out += key;
+  out += "\": [";
+  for (size_t i = 0; i < vals.size(); ++i) {
+    if (i > 0) out += ", ";
+    out += std::to_string(vals[i]);
+  }
+  out += ']';
+}
+void AppendJson(std::string& out, const char* key, const OpStats& op) {
+  out += '"';
+  out += key;
+  out += "\": {";
+  AppendJson(out, "calls", op.calls);
+  out += ", ";
+  AppendJson(out, "edges", op.edges);
+  out += ", ";
+  AppendJson(out, "triangles", op.triangles);
+  out += ", ";
+  AppendJson(out, "max_triangles", op.max_triangles);
+  out += ", ";
+  AppendJson(out, "allocations", op.allocations);
+  out += ", ";
+  AppendJson(out, "max_allocations", op.max_allocations);
+  out += '}';
+}
+}  // namespace
+std::string Order::StatsJson() const {
+  const GraphStats& gs = g_.stats();
+  std::string out = "{\"enabled\": ";
+  out += kStats ? "true" : "false";
+  out += ", \"ops\": {";
+  AppendJson(out, "insert", stats_.insert);
+  out += ", ";
+  AppendJson(out, "batch_insert", stats_.batch_insert);
+  out += ", ";
+  AppendJson(out, "remove", stats_.remove);
+  out += ", ";
+  AppendJson(out, "batch_remove", stats_.batch_remove);
+  out += ", ";
+  AppendJson(out, "redecompose", stats_.redecompose);
+  out += "}, \"om\": {";
+  AppendJson(out, "inserts", stats_.om_inserts);
+  out += ", ";
+  AppendJson(out, "splits", stats_.om_splits);
+  out += ", ";
+  AppendJson(out, "relabels", stats_.om_relabels);
+  out += ", ";
+  AppendJson(out, "relabel_groups", stats_.om_relabel_groups);
+  out += ", ";
+  AppendJson(out, "relabel_max", stats_.om_relabel_max);
+  out += ", ";
+  AppendJson(out, "retags", stats_.om_retags);
+  out += "}, \"heap\": {";
+  AppendJson(out, "pushes", stats_.hp_pushes);
+  out += ", ";
+  AppendJson(out, "pops", stats_.hp_pops);
+  out += "}, \"candidates\": {";
+  AppendJson(out, "total", stats_.cand);
+  out += ", ";
+  AppendJson(out, "max", stats_.cand_max);
+  out += "}, \"cascade\": {";
+  AppendJson(out, "edges", stats_.cascade);
+  out += ", ";
+  AppendJson(out, "depth", stats_.depth);
+  out += "}, ";
+  AppendJson(out, "changed", stats_.changed);
+  out += ", \"graph\": {";
+  AppendJson(out, "inserts", gs.inserts);
+  out += ", ";
+  AppendJson(out, "removes", gs.removes);
+  out += ", ";
+  AppendJson(out, "scanned", gs.scanned);
+  out += ", ";
+  AppendJson(out, "shifted", gs.shifted);
+  out += "}}";
+  return out;
+}
+// per-vertex summary
+void Order::VertexLoad() {
+  vhist_.assign(n_, std::vector<uint32_t>());
+  for (EidT e = node_[l_].next; kNil != e; e = node_[e].next) {
+    VertexChange(e, -1, hot_[e].k);
+  }
+}
+void Order::VertexChange(const EidT e, const int32_t from, const int32_t to) {
+  const auto edge = g_.Get(e);
+  for (const VidT v : {edge.first, edge.second}) {
+    auto& hist = vhist_[v];
+    if (from >= 0) {
+      --hist[from];
+      // keep the last entry positive
+      while (!hist.empty() && 0 == hist.back()) hist.pop_back();
+    }
+    if (to >= 0) {
+      if (hist.size() <= static_cast<size_t>(to)) hist.resize(to + 1, 0);
+      ++hist[to];
+    }
+  }
+}
+// skyline
+void Order::Attach(Skyline* sky, const uint32_t layer) {
+  sky_ = sky;
+  layer_ = layer;
+  if (nullptr == sky_) return;
+  for (EidT e = node_[l_].next; kNil != e; e = node_[e].next) {
+    SkyChange(e, hot_[e].k);
+  }
+}
+void Order::SkyChange(const EidT e, const int32_t k) {
+  sky_->Set(g_.Get(e), layer_, k);
+}
+// community index
+void Order::CommChange(const EidT e, const int32_t from, const int32_t to) {
+  // the edge joins or leaves the levels in (min(from, to), max(from, to)]
+  const int32_t hi = std::min<int32_t>(std::max(from, to), comm_.size() - 1);
+  for (int32_t k = std::min(from, to) + 1; k <= hi; ++k) {
+    CommLevel& c = comm_[k];
+    if (c.stale) continue;
+    if (from > to || c.pending.size() >= g_.m()) {
+      // a rebuild is due anyway
+      c.stale = true;
+      decltype(c.pending)().swap(c.pending);
+    } else {
+      c.pending.push_back(e);
+    }
+  }
+}
+Order::CommLevel& Order::CommLoad(const int32_t k) {
+  if (comm_.size() <= static_cast<size_t>(k)) comm_.resize(k + 1);
+  CommLevel& c = comm_[k];
+  if (c.stale) {
+    c.parent.resize(l_);
+    std::iota(c.parent.begin(), c.parent.end(), 0);
+    c.size.assign(l_, 1);
+    c.pending.clear();
+    for (EidT e = First(k); kNil != e; e = node_[e].next) {
+      c.pending.push_back(e);
+    }
+    c.stale = false;
+  }
+  // union each new edge with the edges sharing a triangle with it
+  for (const EidT e : c.pending) {
+    if (!g_.Contain(e) || hot_[e].k < k) continue;
+    for (const auto tri : g_.GetCycles(e)) {
+      if (hot_[tri.first].k < k || hot_[tri.second].k < k) continue;
+      for (const EidT o : {tri.first, tri.second}) {
+        EidT r1 = CommFind(c, e), r2 = CommFind(c, o);
+        if (r1 == r2) continue;
+        if (c.size[r1] < c.size[r2]) std::swap(r1, r2);
+        c.parent[r2] = r1;
+        c.size[r1] += c.size[r2];
+      }
+    }
+  }
+  decltype(c.pending)().swap(c.pending);
+  return c;
+}
+EidT Order::CommFind(CommLevel& c, EidT e) {
+  // path halving
+  while (c.parent[e] != e) {
+    c.parent[e] = c.parent[c.parent[e]];
+    e = c.parent[e];
+  }
+  return e;
+}
+// parallel helpers
+void Order::Prefetch(const std::vector<EidT>& es, const size_t from) {
+  // on one thread, enumerating on demand saves the cache
+  if (1 == Threads()) return;
+  std::vector<EidT> todo;
+  for (size_t i = from; i < es.size(); ++i) {
+    if (!tris_.count(es[i])) todo.push_back(es[i]);
+  }
+  std::vector<std::vector<std::pair<EidT, EidT>>> tris(todo.size());
+  ParallelFor(todo.size(), [this, &todo, &tris](const size_t i) {
+    tris[i] = g_.GetCycles(todo[i]);
+  }, 64);
+  for (size_t i = 0; i < todo.size(); ++i) {
+    tris_.emplace(todo[i], std::move(tris[i]));
+  }
+}
+void Order::RankLoad() {
+  // the rank of the first edge in each group: the groups are in the order
+  // of the list, so it is one plus the # of edges in the groups before
+  std::vector<EidT> start(l_ + 2, 0);
+  for (EidT g = 0, r = 1; l_ + 1 != g; g = om_nodes_[g].next) {
+    start[g] = r;
+    r += om_cnt_[g];
+  }
+  // each group is ranked by the thread that finds its first edge
+  ParallelFor(l_ + 1, [this, &start](const size_t e) {
+    if (l_ != e && (!g_.Contain(e) ||
+                    hot_[node_[e].prev].grp == hot_[e].grp)) return;
+    const EidT grp = hot_[e].grp;
+    EidT r = start[grp];
+    for (EidT f = e, c = 0; c < om_cnt_[grp]; ++c, f = node_[f].next) {
+      rank_[f] = r++;
+    }
+  });
+}
+// edge ID capacity
+void Order::Reserve(const EidT need) {
+  if (need <= l_) return;
+  // grow by chunks of at least l_ / 8 IDs
+  const EidT ol = l_;
+  const EidT nl = std::max(need, ol + std::max(ol / 8, EidT{64}));
+  ASSERT_MSG(nl < (EidT{1} << kIdBits),
+             "it is required l < 2^29 for the ease of implementation");
+  g_.Reserve(nl);
+  EdgeHot none = EdgeHot();
+  none.k = -1;
+  Fit(hot_, nl + 1, none);
+  Fit(node_, nl + 1);
+  Fit(hp_pos_, nl + 1, kNil);
+  Fit(om_nodes_, nl + 2);
+  Fit(om_cnt_, nl + 2, uint32_t{0});
+  // move the head of the list from @ol to @nl; the tags are kept as they are
+  hot_[nl] = hot_[ol];
+  hot_[ol] = none;
+  node_[nl] = node_[ol];
+  if (kNil != node_[nl].next) node_[node_[nl].next].prev = nl;
+  // move the end mark of the order from @ol + 1 to @nl + 1
+  om_nodes_[nl + 1] = om_nodes_[ol + 1];
+  om_nodes_[om_nodes_[nl + 1].prev].next = nl + 1;
+  // the group ids @ol + 1, ..., @nl become available
+  for (EidT g = nl; g > ol; --g) {
+    om_nodes_[g].prev = kNil;
+    om_nodes_[g].next = om_avail_;
+    om_nodes_[om_avail_].prev = g;
+    om_avail_ = g;
+  }
+  // the new IDs are singletons in the community index
+  for (auto& c : comm_) {
+    if (c.stale) continue;
+    c.parent.resize(nl);
+    std::iota(c.parent.begin() + ol, c.parent.end(), ol);
+    c.size.resize(nl, 1);
+  }
+  l_ = nl;
+}
+void Order::Compact() {
+  // compact only if at most a quarter of the IDs are in use
+  const EidT m = g_.m();
+  if (l_ <= 64 || m >= l_ / 4) return;
+  const EidT ol = l_;
+  const EidT nl = std::max(m * 2, EidT{64});
+  // 1. move the edges with IDs >= @nl to the free IDs < @nl
+  for (EidT e = nl, fe = 0; e < ol; ++e) {
+    if (!g_.Contain(e)) continue;
+    while (g_.Contain(fe)) ++fe;
+    g_.Relabel(e, fe);
+    hot_[fe] = hot_[e];
+    node_[fe] = node_[e];
+    node_[node_[fe].prev].next = fe;
+    if (kNil != node_[fe].next) node_[node_[fe].next].prev = fe;
+    const int32_t k = hot_[fe].k;
+    if (e == head_[k]) head_[k] = fe;
+    if (e == tail_[k]) tail_[k] = fe;
+  }
+  if (track_) touched_all_ = true;
+  // 2. move the head of the list from @ol to @nl
+  hot_[nl] = hot_[ol];
+  node_[nl] = node_[ol];
+  if (kNil != node_[nl].next) node_[node_[nl].next].prev = nl;
+  // 3. renumber the used groups in order; the end mark becomes @nl + 1
+  std::vector<EidT> gid(ol + 2, kNil);
+  EidT used = 0;
+  for (EidT g = 0; ol + 1 != g; g = om_nodes_[g].next) gid[g] = used++;
+  std::vector<OMNode> nodes(nl + 2);
+  std::vector<uint32_t> cnt(nl + 2, 0);
+  for (EidT g = 0; ol + 1 != g; g = om_nodes_[g].next) {
+    const EidT ng = gid[g];
+    nodes[ng].tag = om_nodes_[g].tag;
+    nodes[ng].prev = 0 == ng ? kNil : ng - 1;
+    nodes[ng].next = used == ng + 1 ? nl + 1 : ng + 1;
+    cnt[ng] = om_cnt_[g];
+  }
+  nodes[nl + 1].tag = om_nodes_[ol + 1].tag;
+  nodes[nl + 1].prev = used - 1;
+  nodes[nl + 1].next = kNil;
+  // the group ids @used, ..., @nl are available
+  om_avail_ = used;
+  for (EidT g = used; g <= nl; ++g) {
+    nodes[g].prev = used == g ? kNil : g - 1;
+    nodes[g].next = nl == g ? kNil : g + 1;
+  }
+  for (EidT e = nl; kNil != e; e = node_[e].next) {
+    hot_[e].grp = gid[hot_[e].grp];
+  }
+  om_nodes_.swap(nodes);
+  om_cnt_.swap(cnt);
+  // 4. release the memory; the community labels are edge IDs
+  comm_.clear();
+  g_.Shrink(nl);
+  Fit(hot_, nl + 1);
+  Fit(node_, nl + 1);
+  Fit(hp_pos_, nl + 1);
+  l_ = nl;
 }
 // list maintenance
-void Order::ListInsert(const uint32_t e1, const uint32_t e2) {
+void Order::ListLoad(const std::vector<EidT>& ord) {
+  // @l_ is always the head of the list
+  head_.clear();
+  tail_.clear();
+  EidT prev_e = l_;
+  node_[l_].prev = node_[l_].next = kNil;
+  for (const EidT e : ord) {
+    const uint32_t k = hot_[e].k;
+    // the sublist of all edges with trussness k
+    if (head_.size() <= k) {
+      ASSERT(head_.size() == tail_.size());
+      head_.resize(k + 1, kNil);
+      tail_.resize(k + 1, kNil);
+    }
+    if (kNil == head_[k]) head_[k] = e;
+    tail_[k] = e;
+    // set the list node
+    node_[prev_e].next = e;
+    node_[e].prev = prev_e;
+    node_[e].next = kNil;
+    hot_[e].ext = 0;
+    // set e as the new prev_e
+    prev_e = e;
+  }
+}
+void Order::ListInsert(const EidT e1, const EidT e2) {
+  if (track_) touched_.push_back(e1);
   node_[e1].next = node_[e2].next;
   node_[e1].prev = e2;
   node_[e2].next = e1;
-  if (UINT32_MAX != node_[e1].next) node_[node_[e1].next].prev = e1;
+  if (kNil != node_[e1].next) node_[node_[e1].next].prev = e1;
 }
-void Order::ListRemove(const uint32_t e, uint32_t& head, uint32_t& tail) {
+void Order::ListRemove(const EidT e, EidT& head, EidT& tail) {
+  if (track_) touched_.push_back(e);
   if (head == tail) {
-    head = tail = UINT32_MAX;
+    head = tail = kNil;
   } else if (e == head) {
     head = node_[e].next;
   } else if (e == tail) {
     tail = node_[e].prev;
   }
-  if (UINT32_MAX != node_[e].prev) {
+  if (kNil != node_[e].prev) {
     node_[node_[e].prev].next = node_[e].next;
   }
-  if (UINT32_MAX != node_[e].next) {
+  if (kNil != node_[e].next) {
     node_[node_[e].next].prev = node_[e].prev;
   }
-  node_[e].prev = node_[e].next = UINT32_MAX;
+  node_[e].prev = node_[e].next = kNil;
 }
 // order maintenance
 void Order::OMLoad() {
-  ASSERT(l_ >= 64 && l_ < (static_cast<uint32_t>(1) << 29));
+  ASSERT(l_ >= 64 && l_ < (EidT{1} << kIdBits));
   om_nodes_ = std::vector<OMNode>(l_ + 2);
-  om_tag_ = std::vector<uint64_t>(l_ + 1, 0);
-  om_grp_ = std::vector<uint32_t>(l_ + 1, 0);
+  for (auto& h : hot_) h.tag = h.grp = 0;
   om_cnt_ = std::vector<uint32_t>(l_ + 2, 0);
   // available group ids
   om_avail_ = 0;
-  om_nodes_[0].prev = om_nodes_[l_].next = UINT32_MAX;
-  for (uint32_t i = 1; i <= l_; ++i) {
+  om_nodes_[0].prev = om_nodes_[l_].next = kNil;
+  for (EidT i = 1; i <= l_; ++i) {
     om_nodes_[i].prev = i - 1;
     om_nodes_[i - 1].next = i;
   }
   // bulkload
-  const uint64_t step = (static_cast<uint64_t>(1) << 60) / (l_ + 1);
+  const TagT step = kTagEnd / (l_ + 1);
   uint32_t cnt = 0;
-  uint32_t tgid = UINT32_MAX;
-  for (uint32_t p = l_; UINT32_MAX != p; p = node_[p].next) {
+  EidT tgid = kNil;
+  for (EidT p = l_; kNil != p; p = node_[p].next) {
     if (unlikely(0 == cnt)) {
       // initialize the group
       tgid = om_avail_;
       om_avail_ = om_nodes_[om_avail_].next;
-      om_nodes_[om_avail_].prev = UINT32_MAX;
+      om_nodes_[om_avail_].prev = kNil;
       om_nodes_[tgid].next = l_ + 1;
       if (0 == tgid) {
-        om_nodes_[tgid].prev = UINT32_MAX;
+        om_nodes_[tgid].prev = kNil;
         om_nodes_[tgid].tag = 0;
       } else {
         om_nodes_[tgid].prev = tgid - 1;
@@ -910,56 +2025,63 @@ void Order::OMLoad() {
       }
       om_cnt_[tgid] = 1;
       // initialize the edge
-      om_tag_[p] = 0;
-      om_grp_[p] = tgid;
+      hot_[p].tag = 0;
+      hot_[p].grp = tgid;
     } else {
-      om_tag_[p] = om_tag_[node_[p].prev] + (static_cast<uint64_t>(1) << 30);
-      om_grp_[p] = tgid;
+      hot_[p].tag = hot_[node_[p].prev].tag + kTagGap;
+      hot_[p].grp = tgid;
       ++om_cnt_[tgid];
     }
     if (++cnt == om_grp_ub_ / 2) cnt = 0;
   }
   // the end mark of the order
   om_cnt_[l_ + 1] = 0;
-  om_nodes_[l_ + 1].tag = (static_cast<uint64_t>(1) << 60) - 1;
-  om_nodes_[l_ + 1].next = UINT32_MAX;
+  om_nodes_[l_ + 1].tag = kTagEnd - 1;
+  om_nodes_[l_ + 1].next = kNil;
   om_nodes_[l_ + 1].prev = tgid;
 }
-void Order::OMInsert(const uint32_t e1, const uint32_t e2) {
+void Order::OMInsert(const EidT e1, const EidT e2) {
+  if (kStats) ++stats_.om_inserts;
   // the group is full; that is, a new group needs to be created
-  if (om_cnt_[om_grp_[e2]] == om_grp_ub_) {
+  if (om_cnt_[hot_[e2].grp] == om_grp_ub_) {
     // the new group id
-    const uint32_t ngid = om_avail_;
+    const EidT ngid = om_avail_;
     om_avail_ = om_nodes_[om_avail_].next;
-    om_nodes_[om_avail_].prev = UINT32_MAX;
+    om_nodes_[om_avail_].prev = kNil;
     // the group to which e2 belongs and the next group
-    const uint32_t gid1 = om_grp_[e2];
-    const uint32_t gid2 = om_nodes_[gid1].next;
+    const EidT gid1 = hot_[e2].grp;
+    const EidT gid2 = om_nodes_[gid1].next;
+    if (kStats) ++stats_.om_splits;
     // there is no vacancy; relabeling is needed
     if (om_nodes_[gid1].tag + 1 == om_nodes_[gid2].tag) {
-      const uint64_t tag = om_nodes_[gid1].tag;
-      uint32_t cnt = 1;
-      uint32_t threshold = 1;
-      uint64_t mask = UINT64_MAX;
-      uint32_t ph = gid1, pe = gid1;
+      const TagT tag = om_nodes_[gid1].tag;
+      EidT cnt = 1;
+      EidT threshold = 1;
+      TagT mask = ~TagT{0};
+      EidT ph = gid1, pe = gid1;
       // find the "smallest" enclosing tag range with low enough density
       while (cnt >= threshold) {
         threshold = threshold << 1;
         mask = mask << 2;
-        while (UINT32_MAX != om_nodes_[ph].prev &&
+        while (kNil != om_nodes_[ph].prev &&
                (om_nodes_[om_nodes_[ph].prev].tag & mask) == (tag & mask)) {
           ph = om_nodes_[ph].prev;
           ++cnt;
         }
-        while (UINT32_MAX != om_nodes_[pe].next &&
+        while (kNil != om_nodes_[pe].next &&
                (om_nodes_[om_nodes_[pe].next].tag & mask) == (tag & mask)) {
           pe = om_nodes_[pe].next;
           ++cnt;
         }
       }
-      const uint64_t step = ((~mask) + 1) / cnt;
+      const TagT step = ((~mask) + 1) / cnt;
+      if (kStats) {
+        ++stats_.om_relabels;
+        stats_.om_relabel_groups += cnt;
+        stats_.om_relabel_max = std::max<uint64_t>(stats_.om_relabel_max, cnt);
+      }
       om_nodes_[ph].tag = (tag & mask);
-      uint32_t p = om_nodes_[ph].next;
+      EidT p = om_nodes_[ph].next;
       while (--cnt > 0) {
         om_nodes_[p].tag = om_nodes_[om_nodes_[p].prev].tag + step;
         p = om_nodes_[p].next;
@@ -975,92 +2097,93 @@ void Order::OMInsert(const uint32_t e1, const uint32_t e2) {
     om_nodes_[ngid].tag = om_nodes_[gid1].tag + 1;
     // distribute the edges
     // step 1. find the first edge in the group
-    uint32_t p = e2;
-    while (UINT32_MAX != node_[p].prev && gid1 == om_grp_[node_[p].prev]) {
+    EidT p = e2;
+    while (kNil != node_[p].prev && gid1 == hot_[node_[p].prev].grp) {
       p = node_[p].prev;
     }
     uint32_t cnt = 0;
     // step 2. assign new tags to the edges remaining in the original group
-    om_tag_[p] = 0;
+    hot_[p].tag = 0;
     p = node_[p].next;
     while (++cnt < om_grp_ub_ / 2) {
-      om_tag_[p] = om_tag_[node_[p].prev] + (static_cast<uint64_t>(1) << 30);
+      hot_[p].tag = hot_[node_[p].prev].tag + kTagGap;
       p = node_[p].next;
     }
     om_cnt_[gid1] = om_grp_ub_ / 2;
     // step 3. distribute the edges
-    om_tag_[p] = 0;
-    om_grp_[p] = ngid;
+    hot_[p].tag = 0;
+    hot_[p].grp = ngid;
     p = node_[p].next;
     while (++cnt < om_grp_ub_) {
-      om_tag_[p] = om_tag_[node_[p].prev] + (static_cast<uint64_t>(1) << 30);
-      om_grp_[p] = ngid;
+      hot_[p].tag = hot_[node_[p].prev].tag + kTagGap;
+      hot_[p].grp = ngid;
       p = node_[p].next;
     }
     om_cnt_[ngid] = om_grp_ub_ - om_grp_ub_ / 2;
     // in case @om_grp_ub_ is set as an odd number
     ASSERT(om_cnt_[ngid] == om_cnt_[gid1]);
   }
-  // whether to relabel the edges in group @om_grp_[e2]
+  // whether to relabel the edges in group @hot_[e2].grp
   bool relabel = false;
-  const uint32_t e3 = node_[e2].next;
-  if (UINT32_MAX == e3 || om_grp_[e3] != om_grp_[e2]) {
-    relabel = (om_tag_[e2] >= (static_cast<uint64_t>(1) << 60));
+  const EidT e3 = node_[e2].next;
+  if (kNil == e3 || hot_[e3].grp != hot_[e2].grp) {
+    relabel = (hot_[e2].tag >= kTagEnd);
   } else {
-    relabel = (om_tag_[e2] + 1 == om_tag_[e3]);
+    relabel = (hot_[e2].tag + 1 == hot_[e3].tag);
   }
   if (relabel) {
-    const uint32_t gid1 = om_grp_[e2];
-    uint32_t p = e2;
-    while (UINT32_MAX != node_[p].prev && gid1 == om_grp_[node_[p].prev]) {
+    if (kStats) ++stats_.om_retags;
+    const EidT gid1 = hot_[e2].grp;
+    EidT p = e2;
+    while (kNil != node_[p].prev && gid1 == hot_[node_[p].prev].grp) {
       p = node_[p].prev;
     }
-    om_tag_[p] = 0;
+    hot_[p].tag = 0;
     p = node_[p].next;
-    while (UINT32_MAX != p && gid1 == om_grp_[p]) {
-      om_tag_[p] = om_tag_[node_[p].prev] + (static_cast<uint64_t>(1) << 30);
+    while (kNil != p && gid1 == hot_[p].grp) {
+      hot_[p].tag = hot_[node_[p].prev].tag + kTagGap;
       p = node_[p].next;
     }
   }
   // set the new edge
-  ++om_cnt_[om_grp_[e2]];
-  om_grp_[e1] = om_grp_[e2];
-  if (UINT32_MAX == e3 || om_grp_[e3] != om_grp_[e2]) {
-    om_tag_[e1] = om_tag_[e2] + (static_cast<uint64_t>(1) << 30);
+  ++om_cnt_[hot_[e2].grp];
+  hot_[e1].grp = hot_[e2].grp;
+  if (kNil == e3 || hot_[e3].grp != hot_[e2].grp) {
+    hot_[e1].tag = hot_[e2].tag + kTagGap;
   } else {
-    om_tag_[e1] = (om_tag_[e2] + om_tag_[e3]) / 2;
+    hot_[e1].tag = (hot_[e2].tag + hot_[e3].tag) / 2;
   }
 }
-void Order::OMRemove(const uint32_t e) {
-  const uint32_t gid = om_grp_[e];
+void Order::OMRemove(const EidT e) {
+  const EidT gid = hot_[e].grp;
   ASSERT(om_cnt_[gid] >= 1);
   if (1 == om_cnt_[gid]) {
     om_nodes_[om_nodes_[gid].prev].next = om_nodes_[gid].next;
     om_nodes_[om_nodes_[gid].next].prev = om_nodes_[gid].prev;
     // update the available groups
-    om_nodes_[gid].prev = UINT32_MAX;
+    om_nodes_[gid].prev = kNil;
     om_nodes_[gid].next = om_avail_;
     om_nodes_[om_avail_].prev = gid;
     om_avail_ = gid;
   }
   --om_cnt_[gid];
 }
-bool Order::OMPred(const uint32_t e1, const uint32_t e2) const {
-  if (om_grp_[e1] == om_grp_[e2]) {
-    return om_tag_[e1] < om_tag_[e2];
+bool Order::OMPred(const EidT e1, const EidT e2) const {
+  if (hot_[e1].grp == hot_[e2].grp) {
+    return hot_[e1].tag < hot_[e2].tag;
   } else {
-    return om_nodes_[om_grp_[e1]].tag < om_nodes_[om_grp_[e2]].tag;
+    return om_nodes_[hot_[e1].grp].tag < om_nodes_[hot_[e2].grp].tag;
   }
 }
 // heap maintenance
 void Order::HPInit() {
-  ASSERT(0 < l_ && l_ < (static_cast<uint32_t>(1) << 29));
-  hp_pos_.resize(l_ + 1, UINT32_MAX);
-  hp_tbl_.push_back(UINT32_MAX);
+  ASSERT(0 < l_ && l_ < (EidT{1} << kIdBits));
+  hp_pos_.resize(l_ + 1, kNil);
+  hp_tbl_.push_back(kNil);
 }
-void Order::HPUp(const uint32_t h, const uint32_t e) {
-  uint32_t c = h;
-  uint32_t p = c / 2;
+void Order::HPUp(const EidT h, const EidT e) {
+  EidT c = h;
+  EidT p = c / 2;
   while (0 != p && OMPred(e, hp_tbl_[p])) {
     hp_tbl_[c] = hp_tbl_[p];
     hp_pos_[hp_tbl_[p]] = c;
@@ -1070,10 +2193,10 @@ void Order::HPUp(const uint32_t h, const uint32_t e) {
   hp_tbl_[c] = e;
   hp_pos_[e] = c;
 }
-void Order::HPDown(const uint32_t h, const uint32_t e) {
-  const uint32_t size = hp_tbl_.size();
-  uint32_t p = h;
-  uint32_t c = p * 2;
+void Order::HPDown(const EidT h, const EidT e) {
+  const EidT size = hp_tbl_.size();
+  EidT p = h;
+  EidT c = p * 2;
   while (c < size) {
     if (c + 1 < size && OMPred(hp_tbl_[c + 1], hp_tbl_[c])) ++c;
     if (OMPred(e, hp_tbl_[c])) break;
@@ -1085,104 +2208,154 @@ void Order::HPDown(const uint32_t h, const uint32_t e) {
   hp_tbl_[p] = e;
   hp_pos_[e] = p;
 }
-void Order::HPInsert(const uint32_t e) {
-  ASSERT(UINT32_MAX == hp_pos_.at(e));
-  const uint32_t size = hp_tbl_.size();
+void Order::HPInsert(const EidT e) {
+  ASSERT(kNil == hp_pos_.at(e));
+  if (kStats) ++stats_.hp_pushes;
+  const EidT size = hp_tbl_.size();
   hp_tbl_.push_back(e);
   HPUp(size, e);
 }
-void Order::HPDelete(const uint32_t e) {
-  ASSERT(UINT32_MAX != hp_pos_.at(e));
-  const uint32_t size = hp_tbl_.size() - 1;
-  const uint32_t e2 = hp_tbl_[size];
+void Order::HPDelete(const EidT e) {
+  ASSERT(kNil != hp_pos_.at(e));
+  if (kStats) ++stats_.hp_pops;
+  const EidT size = hp_tbl_.size() - 1;
+  const EidT e2 = hp_tbl_[size];
   hp_tbl_.pop_back();
   // shift down or up
   if (size != hp_pos_[e]) {
-    const uint32_t h = hp_pos_[e];
+    const EidT h = hp_pos_[e];
     if (h / 2 != 0 && OMPred(e2, hp_tbl_[h / 2])) {
       HPUp(h, e2);
     } else {
       HPDown(h, e2);
     }
   }
-  hp_pos_[e] = UINT32_MAX;
+  hp_pos_[e] = kNil;
 }
-uint32_t Order::HPTop() const {
+EidT Order::HPTop() const {
   ASSERT(hp_tbl_.size() > 1);
   return hp_tbl_[1];
 }
 
 
-std::vector<uint32_t> intersection(std::vector<ArrayEntry>& nums1, std::vector<ArrayEntry>& nums2) {
-    if (nums1.empty() || nums2.empty()){
-        return std::vector<uint32_t>();
-    }
-    std::vector<uint32_t> a1, a2;
-    for(auto e: nums1){
-      a1.push_back(e.vid);
-    }
-    for(auto e: nums2){
-      a2.push_back(e.vid);
+void intersection(const std::vector<ArrayEntry>& nums1,
+                  const std::vector<ArrayEntry>& nums2,
+                  std::vector<VidT>& out) {
+  out.clear();
+  size_t p1 = 0, p2 = 0;
+  while (p1 < nums1.size() && p2 < nums2.size()) {
+    if (nums1[p1].vid == nums2[p2].vid) {
+      out.push_back(nums1[p1].vid);
+      ++p1; ++p2;
+    } else if (nums1[p1].vid < nums2[p2].vid) {
+      ++p1;
+    } else {
+      ++p2;
     }
-    std::unordered_set<uint32_t> set{a1.cbegin(), a1.cend()};
-    std::vector<uint32_t> intersections;
-    for (auto n: a2){
-        if (set.erase(n) > 0){ // if n exists in set, then 1 is returned and n is erased; otherwise, 0.
-            intersections.push_back(n);
-        } 
+  }
+}
+std::vector<VidT> intersection(const std::vector<ArrayEntry>& nums1,
+                               const std::vector<ArrayEntry>& nums2) {
+  std::vector<VidT> out;
+  intersection(nums1, nums2, out);
+  return out;
+}
+
+namespace {
+// append the IDs of the edges to the common vertices of two sorted
+// adjacency arrays to @out, in increasing order of the vertices
+void intersecedge(const std::vector<ArrayEntry>& nums1,
+                  const std::vector<ArrayEntry>& nums2,
+                  std::vector<std::pair<EidT, EidT>>& out) {
+  size_t p1 = 0, p2 = 0;
+  while (p1 < nums1.size() && p2 < nums2.size()) {
+    if (nums1[p1].vid == nums2[p2].vid) {
+      out.push_back({nums1[p1].eid, nums2[p2].eid});
+      ++p1; ++p2;
+    } else if (nums1[p1].vid < nums2[p2].vid) {
+      ++p1;
+    } else {
+      ++p2;
     }
-    return intersections;
+  }
 }
+}  // namespace
 
 
-std::vector<std::pair<uint32_t, uint32_t>> intersecedge(std::vector<ArrayEntry>& nums1, std::vector<ArrayEntry>& nums2) {
-    
-    if (nums1.empty() || nums2.empty()){
-        return std::vector<std::pair<uint32_t, uint32_t>>();
-    }
+const char* StrategyName(const Strategy s) {
+  switch (s) {
+    case Strategy::kUnit: return "unit";
+    case Strategy::kBatch: return "batch";
+    default: return "full";
+  }
+}
 
-    std::vector<uint32_t> a1, a2;
-    for(auto e: nums1){
-      a1.push_back(e.vid);
-    }
-    for(auto e: nums2){
-      a2.push_back(e.vid);
-    }
+CostModel::CostModel() {
+  // ms per unit of work measured on small random graphs; they only matter
+  // until the first measurements come in
+  const double init[2][3] = {{1e-4, 3e-5, 1.5e-4}, {3e-4, 1e-4, 1.5e-4}};
+  for (const bool ins : {false, true}) {
+    for (int s = 0; s < 3; ++s) coef_[ins][s] = init[ins][s];
+  }
+}
 
-    std::unordered_set<uint32_t> set{a1.cbegin(), a1.cend()};
-    std::vector<std::pair<uint32_t, uint32_t>> intersecedges;
-    
+double CostModel::Work(const Strategy s, const uint64_t b, const uint64_t m,
+                       const uint64_t d, const uint64_t w) {
+  switch (s) {
+    case Strategy::kUnit: return static_cast<double>(b + d);
+    case Strategy::kBatch: return static_cast<double>(m + d);
+    default: return static_cast<double>(m + w);
+  }
+}
 
-    for (auto n: a2){
-        if (set.erase(n) > 0){ // if n exists in set, then 1 is returned and n is erased; otherwise, 0.
-            std::pair<uint32_t, uint32_t> arr;
-            uint32_t ar1, ar2;
-            for(auto e: nums1){
-              if(n == e.vid) ar1 = e.eid;
-            }
-            for(auto e: nums2){
-              if(n == e.vid) ar2 = e.eid;
-            }
-            arr = std::make_pair(ar1, ar2);
-            intersecedges.push_back(arr);
-        } 
+Strategy CostModel::Choose(const bool ins, const uint64_t b, const uint64_t m,
+                           const uint64_t d, const uint64_t w) const {
+  Strategy best = Strategy::kUnit;
+  double best_cost = coef(ins, best) * Work(best, b, m, d, w);
+  for (const Strategy s : {Strategy::kBatch, Strategy::kFull}) {
+    // DiBatchInsert requires |\Delta G| > 0.01|G|
+    if (ins && Strategy::kBatch == s && b <= m / 100) continue;
+    const double cost = coef(ins, s) * Work(s, b, m, d, w);
+    if (cost < best_cost) {
+      best = s;
+      best_cost = cost;
     }
-    return intersecedges;
+  }
+  return best;
 }
 
+void CostModel::Update(const bool ins, const Strategy s, const double work,
+                       const double ms) {
+  if (work <= 0) return;
+  double& c = coef_[ins][static_cast<int>(s)];
+  c = (1 - alpha_) * c + alpha_ * ms / work;
+}
 
+uint32_t IndexLayers(const std::string& index_file, const EidT m) {
+  std::ifstream infile(index_file, std::ios::binary | std::ios::ate);
+  ASSERT_MSG(infile.is_open(), "cannot open the index file");
+  const uint64_t size = infile.tellg();
+  const uint64_t header = sizeof(VidT) + sizeof(EidT);
+  const uint64_t layer = uint64_t{m} * 5 * sizeof(EidT);
+  ASSERT_MSG(size >= header && 0 != layer && 0 == (size - header) % layer,
+             "invalid index file");
+  return (size - header) / layer;
+}
 
 void mainFlow(const std::string final_file,
               std::vector<std::vector<ArrayEntry>>& adj_out,
               std::vector<uint32_t>& fs_,
-              uint32_t& maxf){
+              uint32_t& maxf,
+              Profile& prof){
 
-  uint32_t n_, m_;
-  std::vector<std::pair<uint32_t, uint32_t>> edges_;
+  VidT n_;
+  EidT m_;
+  std::vector<std::pair<VidT, VidT>> edges_;
   std::vector<std::vector<ArrayEntry>> adj_in;
   // std::vector<std::vector<ArrayEntry>> adj_out;
   // std::vector<uint32_t> fs_;
-  std::vector<uint32_t> frem_, fts_, ford_;
+  std::vector<uint32_t> frem_, fts_;
+  std::vector<EidT> ford_;
             
   std::ifstream infile(final_file, std::ios::in);
   ASSERT_MSG(infile.is_open(), "cannot open the file");
@@ -1191,7 +2364,7 @@ void mainFlow(const std::string final_file,
   ASSERT_MSG(!infile.eof(), "invalid graph file");
   // read the edges
   while (true) {
-    uint32_t v1, v2;
+    VidT v1, v2;
     infile >> v1 >> v2;
     if (infile.eof()) break;
     edges_.push_back({v1, v2});
@@ -1214,14 +2387,14 @@ void mainFlow(const std::string final_file,
   // initialize adjacency arrays
   adj_out.resize(n_);
   adj_in.resize(n_);
-  for (uint32_t eid = 0; eid < m_; ++eid) {
-    const uint32_t v1 = edges_[eid].first;
-    const uint32_t v2 = edges_[eid].second;
+  for (EidT eid = 0; eid < m_; ++eid) {
+    const VidT v1 = edges_[eid].first;
+    const VidT v2 = edges_[eid].second;
     adj_out[v1].push_back({v2, eid});
     adj_in[v2].push_back({v1, eid});
   }
 
-  for (uint32_t vid = 0; vid < n_; ++vid) {
+  for (VidT vid = 0; vid < n_; ++vid) {
     adj_out[vid].shrink_to_fit();
     adj_in[vid].shrink_to_fit();
     std::sort(adj_out[vid].begin(), adj_out[vid].end(),
@@ -1235,47 +2408,38 @@ void mainFlow(const std::string final_file,
   }
 
 
-  std::vector<uint32_t> verts(n_);
+  prof.Mark("parse", -1);
+  std::vector<VidT> verts(n_);
   std::iota(verts.begin(), verts.end(), 0);
   // uint32_t maxf= 0;
   fs_.resize(m_, 0); ford_.resize(m_); frem_.resize(m_, 0); fts_.resize(m_, 0);
-  for (const uint32_t u : verts) {    
+  // the common neighbors of the endpoints, one buffer per case; they are
+  // sorted and keep their capacity from edge to edge
+  std::vector<VidT> W_1, W_2, W_3;
+  for (const VidT u : verts) {    
     for (const auto ae : adj_out[u]) {
-      const uint32_t v = ae.vid;
-      const uint32_t e = ae.eid;
-      std::vector<uint32_t> W_1, W_2, W_3, W_, tmp;
-      std::vector<std::vector<uint32_t>> W_c;
-      W_1 = intersection(adj_in[u], adj_in[v]); 
-      std::sort(W_1.begin(), W_1.end());
-      W_2 = intersection(adj_out[u], adj_in[v]); 
-      std::sort(W_2.begin(), W_2.end());
-      W_3 = intersection(adj_out[u], adj_out[v]); 
-      std::sort(W_3.begin(), W_3.end());
-      W_c.push_back(W_1);W_c.push_back(W_2);W_c.push_back(W_3);
-      for(auto&& elem: W_c) {
-          std::set_union(elem.begin(), elem.end(), 
-                        W_.begin(), W_.end(),
-                        std::back_inserter(tmp));
-          W_ = std::move(tmp); 
-          tmp.clear();
-      } 
-      W_.erase(std::unique(W_.begin(), W_.end()), W_.end());
+      const VidT v = ae.vid;
+      const EidT e = ae.eid;
+      intersection(adj_in[u], adj_in[v], W_1);
+      intersection(adj_out[u], adj_in[v], W_2);
+      intersection(adj_out[u], adj_out[v], W_3);
       fs_[e] += W_1.size();
       fs_[e] += W_2.size();
       fs_[e] += W_3.size();
     }
   }
 
+  prof.Mark("flow count", -1);
   maxf = *max_element(fs_.cbegin(), fs_.cend()); 
 
-  std::vector<uint32_t> fbin(maxf + 1, 0);
-  for (uint32_t eid = 0; eid < m_; ++eid) ++fbin[fs_[eid]];
-  for (uint32_t i = 0, start = 0; i <= maxf; ++i) {
+  std::vector<EidT> fbin(maxf + 1, 0);
+  for (EidT eid = 0; eid < m_; ++eid) ++fbin[fs_[eid]];
+  for (EidT i = 0, start = 0; i <= maxf; ++i) {
     start += fbin[i];
     fbin[i] = start - fbin[i];
   }
-  std::vector<uint32_t> fpos(m_);
-  for (uint32_t eid = 0; eid < m_; ++eid) {
+  std::vector<EidT> fpos(m_);
+  for (EidT eid = 0; eid < m_; ++eid) {
     fpos[eid] = fbin[fs_[eid]];
     ford_[fpos[eid]] = eid;
     ++fbin[fs_[eid]];
@@ -1285,41 +2449,36 @@ void mainFlow(const std::string final_file,
   
   std::vector<bool> fremoved(m_, false);
   uint32_t f = 0;
-  
-  for (uint32_t i = 0; i < m_; ++i) {
+  // the triangles of an edge, reused by all the edges
+  std::vector<std::pair<EidT, EidT>> ftris;
+  for (EidT i = 0; i < m_; ++i) {
     f = std::max(f, fs_[ford_[i]]);
     ASSERT(fbin[f] == i);
-    const uint32_t eid = ford_[i];
+    const EidT eid = ford_[i];
     ++fbin[fs_[eid]];
     fremoved[eid] = true;
     // find triangles containing the edge with ID eid
-    std::vector<std::pair<uint32_t, uint32_t>> ftris, ftristmp1, ftristmp2; {
-      const uint32_t v1 = edges_[eid].first;
-      const uint32_t v2 = edges_[eid].second;
-      ftris = intersecedge(adj_out[v1], adj_in[v2]); 
-      ftristmp1 = intersecedge(adj_in[v1], adj_in[v2]); 
-      ftristmp2 = intersecedge(adj_out[v1], adj_out[v2]); 
-      for(auto e1: ftristmp1){
-        ftris.push_back(e1);
-      }
-      for(auto e1: ftristmp2){
-        ftris.push_back(e1);
-      }
+    ftris.clear(); {
+      const VidT v1 = edges_[eid].first;
+      const VidT v2 = edges_[eid].second;
+      intersecedge(adj_out[v1], adj_in[v2], ftris);
+      intersecedge(adj_in[v1], adj_in[v2], ftris);
+      intersecedge(adj_out[v1], adj_out[v2], ftris);
       ftris.erase(std::unique(ftris.begin(), ftris.end()), ftris.end());
     }
     // update frem_[eid] and fts_[eid]
     for (const auto tri : ftris) {
-      const uint32_t e1 = tri.first;
-      const uint32_t e2 = tri.second;
+      const EidT e1 = tri.first;
+      const EidT e2 = tri.second;
       if (fs_[e1] >= f && fs_[e2] >= f) ++fts_[eid];
       if (fremoved[e1] || fremoved[e2]) continue;
       ++frem_[eid];
-      for (const uint32_t e : {e1, e2}) {
+      for (const EidT e : {e1, e2}) {
         if (fs_[e] > f) {
-          const uint32_t pe3 = fbin[fs_[e]];
-          const uint32_t pe = fpos[e];
+          const EidT pe3 = fbin[fs_[e]];
+          const EidT pe = fpos[e];
           if (pe3 != pe) {
-            const uint32_t e3 = ford_[pe3];
+            const EidT e3 = ford_[pe3];
             ford_[pe] = e3;
             fpos[e3] = pe;
             ford_[pe3] = e;
@@ -1334,6 +2493,12 @@ void mainFlow(const std::string final_file,
   }
 
 
+  prof.Mark("flow peel", -1);
+  prof.Memory(-1, {{"adjacency", Bytes(adj_in) + Bytes(adj_out)},
+                   {"edges", Bytes(edges_)},
+                   {"flow", Bytes(fs_) + Bytes(frem_) + Bytes(fts_) +
+                            Bytes(ford_) + Bytes(fbin) + Bytes(fpos) +
+                            Bytes(fremoved)}});
   
   std::vector<bool> qualify(m_, true);
   // D_.resize(maxf+1); Dord_.resize(maxf+1); Drem_.resize(maxf+1); Dts_.resize(maxf+1);
@@ -1341,7 +2506,7 @@ void mainFlow(const std::string final_file,
 }
 
 
-void mainDOrder(uint32_t n, uint32_t m, 
+void mainDOrder(VidT n, EidT m, 
                 std::vector<std::vector<ArrayEntry>>& adj_out,
                 std::vector<uint32_t>& fs_,
                 uint32_t& maxf,
@@ -1350,18 +2515,138 @@ void mainDOrder(uint32_t n, uint32_t m,
                 const std::string ground_truth_file, 
                 const std::string final_file,
                 const std::string f_index_file,
-                const std::string op){
-  
-  
+                const std::string op,
+                const std::string snapshot_file,
+                Profile& prof){
+  // report the phases and the memory of a layer, and append them with the
+  // counters of the order, if any, as a JSON line to the file named by the
+  // environment variable TRUSS_STATS if set
+  const char* stats_file = std::getenv("TRUSS_STATS");
+  const auto report = [&op, &prof, stats_file](const int64_t layer,
+                                               const Order* tm) {
+    prof.Print(layer);
+    if (nullptr != stats_file) {
+      std::ofstream out(stats_file, std::ios::app);
+      ASSERT_MSG(out.is_open(), "cannot open the stats file");
+      out << "{\"tool\": \"dm\", \"op\": \"" << op << "\", \"layer\": "
+          << layer << ", ";
+      if (nullptr != tm) out << "\"counters\": " << tm->StatsJson() << ", ";
+      out << prof.Json(layer) << "}\n";
+    }
+  };
+  // the loading of a layer is timed with its parts
+  const auto loaded = [&prof](const Order& tm, const uint32_t curf) {
+    prof.Mark("load", curf);
+    for (const auto& part : tm.load_ms()) {
+      prof.Add("load." + part.first, curf, part.second);
+    }
+  };
+  // apply the updates to a layer one by one, and record their latencies
+  // and the slowest of them, TRUSS_SLOWEST (10 by default), with the
+  // degrees of their endpoints before the update and the # of other edges
+  // whose trussness changed
+  const char* slowest_env = std::getenv("TRUSS_SLOWEST");
+  const size_t slowest_n =
+      nullptr == slowest_env ? 10 : strtoull(slowest_env, nullptr, 10);
+  const auto unit = [&prof, slowest_n](Order& tm, const uint32_t curf,
+                                       const std::vector<EdgT>& edges,
+                                       const bool insert,
+                                       IncrementalCheck& check) {
+    Histogram hist;
+    Slowest slowest(slowest_n);
+    std::vector<EdgT> changed;
+    tm.Journal(&changed);
+    for (const auto edge : edges) {
+      const VidT v1 = edge.first, v2 = edge.second;
+      const size_t deg[] = {tm.OutDegree(v1), tm.InDegree(v1),
+                            tm.OutDegree(v2), tm.InDegree(v2)};
+      changed.clear();
+      const auto beg = std::chrono::steady_clock::now();
+      if (insert) {
+        tm.DiInsert({edge});
+      } else {
+        tm.DiRemove(v1, v2);
+      }
+      const uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - beg).count();
+      hist.Record(ns);
+      check.Updated();
+      if (!slowest.Wants(ns)) continue;
+      std::sort(changed.begin(), changed.end());
+      changed.erase(std::unique(changed.begin(), changed.end()),
+                    changed.end());
+      const size_t others = changed.size() -
+          std::count(changed.begin(), changed.end(), edge);
+      char buf[256];
+      snprintf(buf, sizeof buf,
+               "{\"v1\": %" PRIu64 ", \"v2\": %" PRIu64 ", \"v1_out\": %zu, "
+               "\"v1_in\": %zu, \"v2_out\": %zu, \"v2_in\": %zu, "
+               "\"changed\": %zu}", uint64_t{v1}, uint64_t{v2}, deg[0],
+               deg[1], deg[2], deg[3], others);
+      slowest.Add(ns, buf);
+    }
+    tm.Journal(nullptr);
+    prof.Latency(curf, insert ? "insert" : "remove", hist, slowest);
+  };
+  // verify a maintained layer against the ground truth, as TRUSS_VERIFY
+  // says; a failed verification reports the mismatches and aborts. In the
+  // incremental mode, the updates were checked as they went, so the layer
+  // is checked as in the sampled mode once the background check is done
+  const VerifyMode verify_mode = VerifyModeFromEnv();
+  const auto verify = [&ground_truth_file, &prof, verify_mode](
+      const Order& tm, const uint32_t curf, IncrementalCheck& check) {
+    if (VerifyMode::kOff == verify_mode) return;
+    printf("Verifying the results (%s): ", VerifyModeName(verify_mode));
+    fflush(stdout);
+    check.Wait();
+    const VerifyMode mode = check.on() ? VerifyMode::kSampled : verify_mode;
+    ASSERT_MSG(0 == tm.Verify(ground_truth_file, mode), "wrong answer");
+    printf("Done.\n");
+    prof.Mark("verify", curf);
+  };
+  // finish a maintained layer: save it to <snapshot_file>.<layer> if
+  // requested, and report it
+  const auto finish = [&snapshot_file, &prof, &report](const Order& tm,
+                                                       const uint32_t curf) {
+    if (!snapshot_file.empty()) {
+      tm.Save(snapshot_file + "." + std::to_string(curf));
+      prof.Mark("save", curf);
+    }
+    prof.Memory(curf, tm.Memory());
+    report(curf, &tm);
+    prof.Restart();
+  };
+  // the part of a mixed batch that belongs to the layer curf; as in the
+  // decomposition, the layer l holds the edges whose flow support in the
+  // final graph is at least l, so it gets their insertions, and every
+  // deletion, which the layer drops if it does not hold the edge
+  const auto layer_part = [&adj_out, &fs_](const std::vector<UpdT>& batch,
+                                           const uint32_t curf) {
+    std::vector<UpdT> part;
+    for (const auto& upd : batch) {
+      const VidT v1 = upd.first.first, v2 = upd.first.second;
+      uint32_t f = 0;
+      if (upd.second && v1 < adj_out.size()) {
+        for (const auto ae : adj_out[v1]) {
+          if (ae.vid == v2) {
+            f = fs_[ae.eid];
+            break;
+          }
+        }
+      }
+      if (!upd.second || f >= curf) part.push_back(upd);
+    }
+    return part;
+  };
 
   
   if (op == "uinsert") {
 
-    std::vector<EdgT> inc_edges; uint32_t incf = 0, cureid;
+    std::vector<EdgT> inc_edges; uint32_t incf = 0; EidT cureid;
     std::ifstream inc_file(update_file);
-    uint32_t inc_m = 0; inc_file >> inc_m;
-    for (uint32_t e = 0; e < inc_m; ++e) {
-      uint32_t v1, v2;
+    EidT inc_m = 0; inc_file >> inc_m;
+    for (EidT e = 0; e < inc_m; ++e) {
+      VidT v1, v2;
       inc_file >> v1 >> v2;
       inc_edges.push_back({v1, v2});
       for (const auto ae : adj_out[v1]) {
@@ -1373,20 +2658,24 @@ void mainDOrder(uint32_t n, uint32_t m,
       incf = fs_[cureid] > incf ? fs_[cureid] : incf;
     }
     inc_file.close();
+    prof.Mark("updates", -1);
     for(uint32_t curf = 0; curf< incf; curf++){
-      Order tm(n, m * 2, old_index_file, curf);
+      Order tm(n, m, old_index_file, curf);
+      loaded(tm, curf);
+      IncrementalCheck check(tm, verify_mode);
       printf("unit insert used.\n");
-      for (const auto edge : inc_edges) {
-        tm.DiInsert({edge});
-      }
+      unit(tm, curf, inc_edges, true, check);
+      prof.Mark("maintain", curf);
+      verify(tm, curf, check);
+      finish(tm, curf);
     }
   } else if (op == "binsert") {
 
-    std::vector<EdgT> inc_edges; uint32_t incf = 0, cureid;
+    std::vector<EdgT> inc_edges; uint32_t incf = 0; EidT cureid;
     std::ifstream inc_file(update_file);
-    uint32_t inc_m = 0; inc_file >> inc_m;
-    for (uint32_t e = 0; e < inc_m; ++e) {
-      uint32_t v1, v2;
+    EidT inc_m = 0; inc_file >> inc_m;
+    for (EidT e = 0; e < inc_m; ++e) {
+      VidT v1, v2;
       inc_file >> v1 >> v2;
       inc_edges.push_back({v1, v2});
       for (const auto ae : adj_out[v1]) {
@@ -1398,20 +2687,97 @@ void mainDOrder(uint32_t n, uint32_t m,
       incf = fs_[cureid] > incf ? fs_[cureid] : incf;
     }
     inc_file.close();
+    prof.Mark("updates", -1);
     for(uint32_t curf = 0; curf< incf; curf++){
-      Order tm(n, m * 2, old_index_file, curf);
+      Order tm(n, m, old_index_file, curf);
+      loaded(tm, curf);
+      IncrementalCheck check(tm, verify_mode);
       printf("batch insert used.\n");
       tm.DiBatchInsert(inc_edges);
+      check.Updated();
+      prof.Mark("maintain", curf);
+      verify(tm, curf, check);
+      finish(tm, curf);
+    }
+  } else if (op == "bmixed") {
+    // each update is "+ v1 v2" (insertion) or "- v1 v2" (deletion)
+    std::vector<UpdT> updates;
+    std::ifstream inc_file(update_file);
+    EidT inc_m = 0; inc_file >> inc_m;
+    for (EidT e = 0; e < inc_m; ++e) {
+      char sign = 0;
+      VidT v1, v2;
+      inc_file >> sign >> v1 >> v2;
+      ASSERT_MSG('+' == sign || '-' == sign, "invalid update");
+      updates.push_back({{v1, v2}, '+' == sign});
+    }
+    inc_file.close();
+    // a mixed batch may touch every layer, each with its own part of it
+    const uint32_t mixf = IndexLayers(old_index_file, m);
+    prof.Mark("updates", -1);
+    for(uint32_t curf = 0; curf< mixf; curf++){
+      Order tm(n, m, old_index_file, curf);
+      loaded(tm, curf);
+      IncrementalCheck check(tm, verify_mode);
+      printf("mixed batch used.\n");
+      tm.DiMixedBatch(layer_part(updates, curf));
+      check.Updated();
+      prof.Mark("maintain", curf);
+      verify(tm, curf, check);
+      finish(tm, curf);
+    }
+  } else if (op == "auto") {
+    // the update file holds one or more batches in the format of "bmixed";
+    // the strategies are chosen per batch and per layer
+    std::vector<std::vector<UpdT>> batches;
+    std::ifstream inc_file(update_file);
+    for (EidT inc_m = 0; inc_file >> inc_m; ) {
+      batches.emplace_back();
+      for (EidT e = 0; e < inc_m; ++e) {
+        char sign = 0;
+        VidT v1, v2;
+        inc_file >> sign >> v1 >> v2;
+        ASSERT_MSG('+' == sign || '-' == sign, "invalid update");
+        batches.back().push_back({{v1, v2}, '+' == sign});
+      }
+    }
+    inc_file.close();
+    // the costs measured on a layer guide the choices on the next ones
+    CostModel model;
+    const uint32_t mixf = IndexLayers(old_index_file, m);
+    prof.Mark("updates", -1);
+    for(uint32_t curf = 0; curf< mixf; curf++){
+      Order tm(n, m, old_index_file, curf);
+      loaded(tm, curf);
+      IncrementalCheck check(tm, verify_mode);
+      for (size_t i = 0; i < batches.size(); ++i) {
+        const Plan plan = tm.DiAuto(layer_part(batches[i], curf), model);
+        check.Updated();
+        printf("layer %u batch %zu: %" PRIu64 " deletions (%s), "
+               "%" PRIu64 " insertions (%s)\n", curf, i,
+               uint64_t{plan.ndel}, plan.ndel ? StrategyName(plan.del) : "-",
+               uint64_t{plan.nins}, plan.nins ? StrategyName(plan.ins) : "-");
+      }
+      prof.Mark("maintain", curf);
+      verify(tm, curf, check);
+      finish(tm, curf);
+    }
+    for (const bool ins : {false, true}) {
+      printf("%s cost (ms per unit of work): unit %.3g, batch %.3g, "
+             "full %.3g\n", ins ? "insertion" : "deletion",
+             model.coef(ins, Strategy::kUnit), model.coef(ins, Strategy::kBatch),
+             model.coef(ins, Strategy::kFull));
     }
   } else if (op == "udelete") {
     uint32_t decf = 0;
     std::ifstream infile(f_index_file, std::ios::binary);
-    uint32_t n = 0, m = 0;
+    VidT n = 0;
+    EidT m = 0;
     infile.read(reinterpret_cast<char*>(&n), sizeof n)
           .read(reinterpret_cast<char*>(&m), sizeof m);
     std::vector<std::uint32_t> ofs_; ofs_.resize(m, 0);
     // read the edges and their information
-    for (uint32_t e = 0, buf[5]; e < m; ++e) {
+    for (EidT e = 0, buf[5]; e < m; ++e) {
       infile.read(reinterpret_cast<char*>(buf), sizeof buf);
       // set the truss number, remaining support, and triangle support
 
@@ -1419,11 +2785,11 @@ void mainDOrder(uint32_t n, uint32_t m,
     }
     infile.close();
 
-    std::vector<EdgT> inc_edges; uint32_t cureid;
+    std::vector<EdgT> inc_edges; EidT cureid;
     std::ifstream inc_file(update_file);
-    uint32_t inc_m = 0; inc_file >> inc_m;
-    for (uint32_t e = 0; e < inc_m; ++e) {
-      uint32_t v1, v2;
+    EidT inc_m = 0; inc_file >> inc_m;
+    for (EidT e = 0; e < inc_m; ++e) {
+      VidT v1, v2;
       inc_file >> v1 >> v2;
       inc_edges.push_back({v1, v2});
       for (const auto ae : adj_out[v1]) {
@@ -1435,26 +2801,27 @@ void mainDOrder(uint32_t n, uint32_t m,
       decf = ofs_[cureid] > decf ? ofs_[cureid] : decf;
     }
     inc_file.close();
+    prof.Mark("updates", -1);
     for(uint32_t curf = 0; curf< decf; curf++){
-      Order tm(n, m * 2, old_index_file, curf);
+      Order tm(n, m, old_index_file, curf);
+      loaded(tm, curf);
+      IncrementalCheck check(tm, verify_mode);
       printf("unit delete used.\n");
-      for (const auto edge : inc_edges) {
-        tm.DiRemove(edge.first, edge.second);
-      }
-      printf("Verifying the results: ");
-      tm.Debug();
-      tm.Check(ground_truth_file);
-      printf("Done.\n");
+      unit(tm, curf, inc_edges, false, check);
+      prof.Mark("maintain", curf);
+      verify(tm, curf, check);
+      finish(tm, curf);
     }
   } else {
     uint32_t decf = 0;
     std::ifstream infile(f_index_file, std::ios::binary);
-    uint32_t n = 0, m = 0;
+    VidT n = 0;
+    EidT m = 0;
     infile.read(reinterpret_cast<char*>(&n), sizeof n)
           .read(reinterpret_cast<char*>(&m), sizeof m);
     std::vector<std::uint32_t> ofs_; ofs_.resize(m, 0);
     // read the edges and their information
-    for (uint32_t e = 0, buf[5]; e < m; ++e) {
+    for (EidT e = 0, buf[5]; e < m; ++e) {
       infile.read(reinterpret_cast<char*>(buf), sizeof buf);
       // set the truss number, remaining support, and triangle support
 
@@ -1462,11 +2829,11 @@ void mainDOrder(uint32_t n, uint32_t m,
     }
     infile.close();
 
-    std::vector<EdgT> inc_edges; uint32_t cureid;
+    std::vector<EdgT> inc_edges; EidT cureid;
     std::ifstream inc_file(update_file);
-    uint32_t inc_m = 0; inc_file >> inc_m;
-    for (uint32_t e = 0; e < inc_m; ++e) {
-      uint32_t v1, v2;
+    EidT inc_m = 0; inc_file >> inc_m;
+    for (EidT e = 0; e < inc_m; ++e) {
+      VidT v1, v2;
       inc_file >> v1 >> v2;
       inc_edges.push_back({v1, v2});
       for (const auto ae : adj_out[v1]) {
@@ -1478,18 +2845,22 @@ void mainDOrder(uint32_t n, uint32_t m,
       decf = ofs_[cureid] > decf ? ofs_[cureid] : decf;
     }
     inc_file.close();
+    prof.Mark("updates", -1);
     for(uint32_t curf = 0; curf< decf; curf++){
-      Order tm(n, m * 2, old_index_file, curf);
+      Order tm(n, m, old_index_file, curf);
+      loaded(tm, curf);
+      IncrementalCheck check(tm, verify_mode);
       printf("batch delete used.\n");
       tm.DiBatchRemove(inc_edges);
-      printf("Verifying the results: ");
-      tm.Debug();
-      tm.Check(ground_truth_file);
-      printf("Done.\n");
+      check.Updated();
+      prof.Mark("maintain", curf);
+      verify(tm, curf, check);
+      finish(tm, curf);
     }
   }
 
-  
+  // the phases before the layers
+  report(-1, nullptr);
 }
 
 
@@ -3,24 +3,87 @@
 
 #include <cstdint>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "dgraph.h"
+#include "dstats.h"
 
 namespace truss_maint {
+class Skyline;
 using std::int32_t;
 using std::uint32_t;
+// the order-maintenance tags; the tag space is twice as wide as the IDs
+#ifdef TRUSS_WIDE_IDS
+typedef unsigned __int128 TagT;
+#else
+typedef uint64_t TagT;
+#endif
+// a signed edge update of a mixed batch: (edge, true) inserts the edge and
+// (edge, false) deletes it
+typedef std::pair<EdgT, bool> UpdT;
+// the ways to apply the insertions or the deletions of a batch: one
+// DiInsert/DiRemove per edge, DiBatchInsert/DiBatchRemove, or a full
+// re-decomposition of the updated graph
+enum class Strategy { kUnit, kBatch, kFull };
+const char* StrategyName(const Strategy s);
+// estimates the cost of each strategy as a per-strategy coefficient times
+// the work the strategy is expected to do:
+//   unit:  b + d     (b updates, d the total degree of their endpoints)
+//   batch: m + d     (plus one pass over the m edges of the order)
+//   full:  m + w     (w directed 2-paths scanned by the peeling)
+// the coefficients (ms per unit of work) start from rough defaults and
+// follow the measured costs by an exponentially weighted moving average
+class CostModel final {
+ public:
+  CostModel();
+  // the cheapest strategy; batch insertion needs b > 0.01m
+  Strategy Choose(const bool ins, const uint64_t b, const uint64_t m,
+                  const uint64_t d, const uint64_t w) const;
+  static double Work(const Strategy s, const uint64_t b, const uint64_t m,
+                     const uint64_t d, const uint64_t w);
+  // feed back the measured cost of a strategy
+  void Update(const bool ins, const Strategy s, const double work,
+              const double ms);
+  double coef(const bool ins, const Strategy s) const {
+    return coef_[ins][static_cast<int>(s)];
+  }
+
+ private:
+  // the weight of the latest measurement
+  const double alpha_ = 0.3;
+  // coef_[0] for deletions and coef_[1] for insertions
+  double coef_[2][3];
+};
+// how much of an order Order::Verify checks: nothing, one edge in
+// Order::kVerifyStride, or every edge; kIncremental is checked by an
+// IncrementalCheck as the updates go
+enum class VerifyMode { kOff, kSampled, kFull, kIncremental };
+const char* VerifyModeName(const VerifyMode mode);
+// the mode named by the environment variable TRUSS_VERIFY, "off", "sampled",
+// "full" or "incremental"; full if it is not set
+VerifyMode VerifyModeFromEnv();
+// the strategies picked by Order::DiAuto and the sizes of the net batch
+struct Plan final {
+  Strategy del;
+  Strategy ins;
+  EidT ndel;
+  EidT nins;
+};
 class Order final {
  public:
   // ctors and dtors
   // param n: the # of vertices
-  // param l: for the ease of implementation, a graph can have at most l edges;
-  //          that is, no more edges can be inserted if it has l edges already;
-  //          the space complexity is \Theta(l + n)
-  //          TODO: remove this constraint
+  // param l: the initial # of edge IDs (at least 64 and the # of edges of the
+  //          index @fn, whatever the caller passes); the capacity grows in
+  //          chunks on insertion and is compacted after heavy deletion, so
+  //          the space complexity is \Theta(m + n) for m live edges
   // param fn: the file name
-  Order(const uint32_t n, const uint32_t l, const std::string& fn, uint32_t curf);
+  Order(const VidT n, const EidT l, const std::string& fn, uint32_t curf);
+  // restore the state saved by Save, as it was, without re-sorting the
+  // list or relabeling the order-maintenance groups
+  explicit Order(const std::string& snapshot);
   Order(const Order&) = delete;
   Order& operator=(const Order&) = delete;
   ~Order() {}
@@ -33,77 +96,336 @@ class Order final {
   void DiBatchInsert(const std::vector<EdgT>& nedges);
   // bounded removal
 
-  void DiRemove(const uint32_t v1, const uint32_t v2);
+  void DiRemove(const VidT v1, const VidT v2);
 
   void DiBatchRemove(const std::vector<EdgT>& redges);
-  void LoadIndex(const std::string& fn, uint32_t m, uint32_t n, uint32_t curf);
-  // debug
+  // mixed batch: the batch is reduced to its net effect, then the net
+  // deletions and the net insertions are applied once each
+  void DiMixedBatch(const std::vector<UpdT>& batch);
+  void Normalize(const std::vector<UpdT>& batch, std::vector<EdgT>& redges,
+                 std::vector<EdgT>& nedges) const;
+  // mixed batch with the strategies for its deletions and its insertions
+  // chosen by @model, which learns from the measured costs
+  Plan DiAuto(const std::vector<UpdT>& batch, CostModel& model);
+  // recompute the trussness of every edge from scratch
+  void Redecompose();
+  void LoadIndex(const std::string& fn, EidT m, VidT n, uint32_t curf);
+  // save the complete maintenance state to a snapshot, which is written
+  // aside and renamed over @fn; the community index and the attached
+  // skyline are not saved
+  void Save(const std::string& fn) const;
+  // debug; Debug checks the invariants of the structures and Check also
+  // the trussness against the index @fn, failing on a mismatch
   void Debug() const;
   void Check(const std::string& fn) const;
+  // check the invariants of the structures and, unless @fn is empty, the
+  // trussness of every edge against the index @fn, whose records are
+  // streamed through the endpoint lookup; the triangle-based invariants and
+  // the records are checked in parallel, and in the sampled mode only for
+  // one edge (record) in kVerifyStride. Returns the # of mismatches, of
+  // which the first @report are printed with their context
+  uint64_t Verify(const std::string& fn, const VerifyMode mode,
+                  const size_t report = 10) const;
+  static constexpr EidT kVerifyStride = 16;
+  // record the edges touched by the updates from now on, until turned off
+  void Track(const bool on);
+  // check the invariants of the edges touched since the last call and of
+  // the edges in triangles with them, in parallel, and forget them; all of
+  // the order is checked if its IDs were renumbered meanwhile. Returns the
+  // # of mismatches, of which the first @report are printed
+  uint64_t VerifyTouched(const size_t report = 10);
   // accessors
-  uint32_t l() const { return l_; }
-  uint32_t n() const { return n_; }
+  EidT l() const { return l_; }
+  VidT n() const { return n_; }
   Graph g() const { return g_; }
-  std::vector<int32_t> k() const { return k_; }
+  std::vector<int32_t> k() const;
+  // the in- and out-degree of the vertex v
+  size_t InDegree(const VidT v) const { return g_.InDegree(v); }
+  size_t OutDegree(const VidT v) const { return g_.OutDegree(v); }
+  // whether the edge (v1, v2) exists
+  bool Contain(const VidT v1, const VidT v2) const {
+    return kNil != g_.Find(v1, v2);
+  }
+  // the # of flow triangles that the edge (v1, v2) closes in this layer
+  size_t Flows(const VidT v1, const VidT v2) const {
+    return g_.CountFlows(v1, v2);
+  }
+  // queries; the trussness of the edge (v1, v2), or -1 if there is no such
+  // edge, in O(log deg(v1))
+  int32_t Trussness(const VidT v1, const VidT v2) const {
+    const EidT e = g_.Find(v1, v2);
+    return kNil == e ? -1 : hot_[e].k;
+  }
+  // the edges with trussness at least k, in the order of the list, in time
+  // linear in their # (plus the # of empty trussness levels above k)
+  std::vector<EdgT> Edges(const int32_t k) const;
+  // the largest k such that the vertex v is in the (k, l) D-truss, i.e.,
+  // the largest trussness of its edges, or -1 if v has no edge
+  int32_t VertexTrussness(const VidT v) const {
+    return v < n_ ? static_cast<int32_t>(vhist_[v].size()) - 1 : -1;
+  }
+  // the communities of the (k, l) D-truss that contain the vertex q, as
+  // (label, # of edges) pairs sorted by label; a community is a maximal set
+  // of edges with trussness at least k connected by triangles of such edges
+  std::vector<std::pair<EidT, EidT>> Communities(const int32_t k,
+                                                 const VidT q);
+  // the edges of the community labeled c in the (k, l) D-truss; the labels
+  // are valid until the next update
+  std::vector<EdgT> Members(const int32_t k, const EidT c);
+  // record the endpoints of every edge whose trussness changes from now on
+  // in @changed (with repetitions); nullptr stops the recording
+  void Journal(std::vector<EdgT>* changed) { journal_ = changed; }
+  // the trussness, triangle support and remaining support of the edge
+  // (v1, v2); k = -1 and ts = rem = 0 if there is no such edge
+  void State(const VidT v1, const VidT v2, int32_t& k, uint32_t& ts,
+             uint32_t& rem) const {
+    const EidT e = g_.Find(v1, v2);
+    k = kNil == e ? -1 : hot_[e].k;
+    ts = kNil == e ? 0 : hot_[e].ts;
+    rem = kNil == e ? 0 : hot_[e].rem;
+  }
+  // report the trussness of every edge, now and after every change, to the
+  // skyline @sky as that of layer @layer; nullptr detaches the skyline
+  void Attach(Skyline* sky, const uint32_t layer);
+  // the # of triangles enumerated by the updates so far
+  uint64_t tri_cnt() const { return tri_cnt_; }
+  // the hot-path counters since the construction, which are all zero if
+  // they are compiled out
+  const Stats& stats() const { return stats_; }
+  // the counters of the order and of its graph as a JSON object
+  std::string StatsJson() const;
+  // the wall time in ms of the parts of loading the index: reading it,
+  // rectifying the graph, and building the list, the order maintenance and
+  // the per-vertex summary; empty if the order was not loaded from an index
+  const std::vector<std::pair<std::string, double>>& load_ms() const {
+    return load_ms_;
+  }
+  // the bytes held by each structure
+  MemoryT Memory() const;
 
  private:
+  // the microbenchmarks of dmicro.cc time the private routines in isolation
+  friend struct OrderBench;
+  // the per-edge fields read or written on every triangle visit;
+  // a record is 32 bytes (48 with wide IDs), so the three edges of a
+  // triangle touch at most three cache lines instead of one line per field
+  struct EdgeHot final {
+    TagT tag;           // the tag of the edge in its order-maintenance group
+    EidT grp;           // the order-maintenance group of the edge
+    int32_t k;          // the trussness
+    uint32_t ts;        // the triangle support
+    uint32_t s;         // the support in the candidate graph
+    uint32_t rem;       // the remaining support
+    uint32_t ext : 30;  // the external support
+    uint32_t chg : 1;   // whether the edge is in the candidate set
+    uint32_t fresh : 1; // whether the edge is new (or in the stack)
+  };
+  static_assert(sizeof(EdgeHot) == (4 == sizeof(EidT) ? 32 : 48),
+                "EdgeHot should not straddle more cache lines than needed");
+  // the external support is packed into 30 bits next to the two flags; it is
+  // bounded by the triangles of the edge, so only an edge in 2^30 or more
+  // triangles could overflow it, which IncExt asserts against
+  static constexpr uint32_t kExtMax = (uint32_t{1} << 30) - 1;
+  // the tag space of the order maintenance: group tags are below kTagEnd,
+  // and consecutive tags in a freshly labeled group are kTagGap apart
+  static constexpr TagT kTagEnd = TagT{1} << (sizeof(TagT) * 8 - 4);
+  static constexpr TagT kTagGap = TagT{1} << (sizeof(TagT) * 4 - 2);
+  // the list links, only followed when the order is changed
   struct ListNode final {
-    uint32_t rem;
-    uint32_t ext;
-    uint32_t prev;
-    uint32_t next;
+    EidT prev;
+    EidT next;
   };
   struct OMNode final {
-    uint64_t tag;
-    uint32_t prev;
-    uint32_t next;
+    TagT tag;
+    EidT prev;
+    EidT next;
   };
   //
   
   // list maintenance
-  void ListInsert(const uint32_t e1, const uint32_t e2);
-  void ListRemove(const uint32_t e, uint32_t& head, uint32_t& tail);
+  void ListLoad(const std::vector<EidT>& ord);
+  void ListInsert(const EidT e1, const EidT e2);
+  void ListRemove(const EidT e, EidT& head, EidT& tail);
   // order maintenace
   void OMLoad();
-  void OMInsert(const uint32_t e1, const uint32_t e2);
-  void OMRemove(const uint32_t e);
-  bool OMPred(const uint32_t e1, const uint32_t e2) const;
+  void OMInsert(const EidT e1, const EidT e2);
+  void OMRemove(const EidT e);
+  bool OMPred(const EidT e1, const EidT e2) const;
   // heap maintenance
   void HPInit();
-  void HPUp(const uint32_t h, const uint32_t e);
-  void HPDown(const uint32_t h, const uint32_t e);
-  void HPInsert(const uint32_t e);
-  void HPDelete(const uint32_t e);
-  uint32_t HPTop() const;
+  void HPUp(const EidT h, const EidT e);
+  void HPDown(const EidT h, const EidT e);
+  void HPInsert(const EidT e);
+  void HPDelete(const EidT e);
+  EidT HPTop() const;
+  // the community index; comm_[k] is a union-find over the edges with
+  // trussness at least k, built on the first query of k; increases of the
+  // trussness are unioned in on the next query, while decreases, which may
+  // split a community, mark the level for a rebuild
+  struct CommLevel final {
+    bool stale = true;
+    std::vector<EidT> parent;
+    std::vector<EidT> size;
+    // the edges that joined the level since the last query
+    std::vector<EidT> pending;
+  };
+  // every change of the trussness of a live edge goes through SetK
+  void SetK(const EidT e, const int32_t k) {
+    if (hot_[e].k == k) return;
+    if (!comm_.empty()) CommChange(e, hot_[e].k, k);
+    VertexChange(e, hot_[e].k, k);
+    if (nullptr != sky_) SkyChange(e, k);
+    if (nullptr != journal_) journal_->push_back(g_.Get(e));
+    if (track_) Touch(e, -1 == k);
+    if (kStats && hot_[e].k >= 0 && k >= 0) ++stats_.changed;
+    hot_[e].k = k;
+  }
+  // every increment of the external support goes through IncExt
+  uint32_t IncExt(const EidT e) {
+    ASSERT_MSG(hot_[e].ext < kExtMax, "the external support overflows");
+    return ++hot_[e].ext;
+  }
+  // record @e as touched, and also its triangles if it is being removed,
+  // since they cannot be found once it is gone
+  void Touch(const EidT e, const bool removed) {
+    touched_.push_back(e);
+    if (!removed || !g_.Contain(e)) return;
+    for (const auto tri : g_.GetCycles(e)) {
+      touched_.push_back(tri.first);
+      touched_.push_back(tri.second);
+    }
+  }
+  // count the candidate set entering the level k, and a cascade
+  void CountCandidates(const int32_t k, const size_t size);
+  void CountCascade(const uint32_t depth, const uint64_t edges);
+  void SkyChange(const EidT e, const int32_t k);
+  // the per-vertex summary; vhist_[v][k] is the # of edges incident to v
+  // with trussness k, and the last entry is positive, so a decrease only
+  // pops the entries that drop to zero
+  void VertexLoad();
+  void VertexChange(const EidT e, const int32_t from, const int32_t to);
+  void CommChange(const EidT e, const int32_t from, const int32_t to);
+  CommLevel& CommLoad(const int32_t k);
+  EidT CommFind(CommLevel& c, EidT e);
+  // the first edge of the list with trussness at least k, or kNil
+  EidT First(const int32_t k) const;
+  // edge ID capacity
+  void Reserve(const EidT need);
+  void Compact();
+  // enumerate the triangles containing @e during an update; the result is
+  // valid until the next call of Cycles, TakeCycles or Prefetch
+  const std::vector<std::pair<EidT, EidT>>& Cycles(const EidT e) {
+    const auto it = tris_.find(e);
+    if (tris_.end() != it) {
+      tri_cnt_ += it->second.size();
+      return it->second;
+    }
+    g_.GetCycles(e, buf_.tris);
+    tri_cnt_ += buf_.tris.size();
+    return buf_.tris;
+  }
+  // enumerate the triangles of the edges in es[@from, ...) in parallel and
+  // keep them for Cycles; the graph must not change before the cache is
+  // released
+  void Prefetch(const std::vector<EidT>& es, const size_t from = 0);
+  void ReleaseCycles() { decltype(tris_)().swap(tris_); }
+  // same as Cycles, but drops the prefetched triangles of @e
+  const std::vector<std::pair<EidT, EidT>>& TakeCycles(const EidT e) {
+    const auto it = tris_.find(e);
+    if (tris_.end() == it) return Cycles(e);
+    buf_.tris.swap(it->second);
+    tris_.erase(it);
+    tri_cnt_ += buf_.tris.size();
+    return buf_.tris;
+  }
+  // the order of the list as ranks: rank_[e] < rank_[e'] iff e precedes e'
+  void RankLoad();
+  explicit Order(SnapReader&& snap);
   // members
-  const uint32_t l_;
-  const uint32_t n_;
-  // graph and trussnesses
+  EidT l_;
+  const VidT n_;
+  // graph
   Graph g_;
-  std::vector<int32_t> k_;
-  // basic structures
-  std::vector<bool> chg_;
-  std::vector<bool> new_;
-  std::vector<uint32_t> head_;
-  std::vector<uint32_t> tail_;
-  std::vector<uint32_t> ts_;
-  std::vector<uint32_t> s_;
+  // basic structures; hot_ and node_ have l_ + 1 entries (@l_ is the head)
+  std::vector<EdgeHot> hot_;
   std::vector<ListNode> node_;
+  std::vector<EidT> head_;
+  std::vector<EidT> tail_;
+  uint64_t tri_cnt_ = 0;
+  // the hot-path counters
+  Stats stats_;
+  // the time taken by the parts of LoadIndex
+  std::vector<std::pair<std::string, double>> load_ms_;
+  // the per-vertex trussness histograms
+  std::vector<std::vector<uint32_t>> vhist_;
+  // the community index, indexed by k
+  std::vector<CommLevel> comm_;
+  // the attached skyline and the layer of the order in it
+  Skyline* sky_ = nullptr;
+  uint32_t layer_ = 0;
+  // the edges whose trussness changed, if recorded
+  std::vector<EdgT>* journal_ = nullptr;
+  // the edges touched since the last VerifyTouched, if tracked, and whether
+  // the IDs were renumbered or all edges changed meanwhile
+  bool track_ = false;
+  bool touched_all_ = false;
+  std::vector<EidT> touched_;
+  // the triangles prefetched by Prefetch
+  std::unordered_map<EidT, std::vector<std::pair<EidT, EidT>>> tris_;
+  // the temporaries of the update routines, which clear them at the start
+  // of a call but keep their capacity, so that a run of updates stops
+  // allocating once they have grown to the largest update seen
+  struct Buffers final {
+    std::vector<EidT> cand;   // the candidate set N
+    std::vector<EidT> stack;  // S
+    std::vector<uint32_t> depth;
+    std::vector<EidT> p1, p3, front;
+    std::vector<std::pair<EidT, EidT>> tris;
+    std::vector<std::pair<int32_t, std::pair<EidT, EidT>>> tri_ts, s_tri_ts;
+    std::vector<uint32_t> bin;
+  } buf_;
   // data members for order maintenance
   const uint32_t om_grp_ub_ = 30;
-  uint32_t om_avail_;
+  EidT om_avail_;
   std::vector<OMNode> om_nodes_;
-  std::vector<uint64_t> om_tag_;
-  std::vector<uint32_t> om_grp_;
   std::vector<uint32_t> om_cnt_;
   // data members for heap maintenance
-  std::vector<uint32_t> hp_tbl_;
-  std::vector<uint32_t> hp_pos_;
+  std::vector<EidT> hp_tbl_;
+  std::vector<EidT> hp_pos_;
   // auxiliary array
-  std::vector<uint32_t>& rank_ = hp_pos_;
+  std::vector<EidT>& rank_ = hp_pos_;
 };
 
-void mainDOrder(uint32_t n, uint32_t m, 
+// the checks of TRUSS_VERIFY=incremental on the updates of an order: after
+// each update, the edges it touched and their triangles; every @period
+// updates, all of the order in a forked child, which checks a copy-on-write
+// image of it while the updates go on. A mismatch fails the run at the next
+// update or at Wait. Nothing is checked in the other modes
+class IncrementalCheck final {
+ public:
+  IncrementalCheck(Order& tm, const VerifyMode mode);
+  IncrementalCheck(const IncrementalCheck&) = delete;
+  IncrementalCheck& operator=(const IncrementalCheck&) = delete;
+  ~IncrementalCheck();
+  bool on() const { return on_; }
+  // check the update just applied
+  void Updated();
+  // wait for the check running in the background, if any
+  void Wait() { Reap(true); }
+
+ private:
+  void Reap(const bool block);
+  Order& tm_;
+  const bool on_;
+  // TRUSS_VERIFY_PERIOD, 1024 by default; 0 stops the full checks
+  const uint64_t period_;
+  uint64_t updates_ = 0;
+  int child_ = -1;  // the pid of the background check, or -1
+};
+
+// the phases of every layer and the memory held after it are timed and
+// measured in @prof, which also reports them
+void mainDOrder(VidT n, EidT m, 
                 std::vector<std::vector<ArrayEntry>>& adj_out,
                 std::vector<uint32_t>& fs_,
                 uint32_t& maxf,
@@ -112,12 +434,42 @@ void mainDOrder(uint32_t n, uint32_t m,
                 const std::string ground_truth_file, 
                 const std::string final_file,
                 const std::string f_index_file,
-                const std::string op);
+                const std::string op,
+                const std::string snapshot_file,
+                Profile& prof);
+
+// the # of layers stored in an index file of a graph with m edges
+uint32_t IndexLayers(const std::string& index_file, const EidT m);
+
+// keep the index resident and apply the updates read from stdin, or from
+// the clients of the Unix domain socket @socket_file if it is not empty;
+// if @state_file is not empty, the updates are made durable under it by a
+// write-ahead log and checkpoints
+void mainServe(VidT n, EidT m,
+               const std::string index_file,
+               const std::string socket_file,
+               const std::string state_file);
+// same as mainServe, but the layers are restored from the snapshots
+// <snapshot_file>.0, <snapshot_file>.1, ... saved by Order::Save, or
+// recovered from the durable state <snapshot_file> if it exists
+void mainRestore(const std::string snapshot_file,
+                 const std::string socket_file);
+
+// the common vertices of two sorted adjacency arrays, in increasing order;
+// the second form writes them to @out, which keeps its capacity
+std::vector<VidT> intersection(const std::vector<ArrayEntry>& nums1,
+                               const std::vector<ArrayEntry>& nums2);
+void intersection(const std::vector<ArrayEntry>& nums1,
+                  const std::vector<ArrayEntry>& nums2,
+                  std::vector<VidT>& out);
 
+// the flow supports of the edges of the final graph; parsing the graph,
+// counting the supports and peeling are timed in @prof as phases of layer -1
 void mainFlow(const std::string final_file,
               std::vector<std::vector<ArrayEntry>>& adj_out,
               std::vector<uint32_t>& fs_,
-              uint32_t& maxf);
+              uint32_t& maxf,
+              Profile& prof);
 
 }  // namespace truss_maint
 
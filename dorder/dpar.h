@@ -0,0 +1,52 @@
+#ifndef TRUSS_MAINT_PAR_H_
+#define TRUSS_MAINT_PAR_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "dtrace.h"
+
+namespace truss_maint {
+
+// the # of worker threads used by ParallelFor: the value of the environment
+// variable TRUSS_THREADS if set, and the # of hardware threads otherwise
+inline size_t Threads() {
+  static const size_t threads = []() {
+    const char* env = std::getenv("TRUSS_THREADS");
+    const long t = nullptr == env ? 0 : std::atol(env);
+    if (t > 0) return static_cast<size_t>(t);
+    return static_cast<size_t>(
+        std::max(1u, std::thread::hardware_concurrency()));
+  }();
+  return threads;
+}
+
+// call fn(i) for all i in [0, n), splitting the range into one contiguous
+// chunk per thread; fn must be safe to call concurrently on distinct i;
+// each thread gets at least @grain iterations, since spawning a thread for
+// fewer does not pay off
+template <typename Fn>
+void ParallelFor(const size_t n, const Fn& fn, const size_t grain = 1024) {
+  const size_t t = std::min(Threads(), (n + grain - 1) / grain);
+  if (t <= 1) {
+    for (size_t i = 0; i < n; ++i) fn(i);
+    return;
+  }
+  std::vector<std::thread> workers;
+  for (size_t w = 0; w < t; ++w) {
+    const size_t beg = n * w / t;
+    const size_t end = n * (w + 1) / t;
+    workers.emplace_back([&fn, beg, end]() {
+      TraceScope scope("ParallelFor", "items", end - beg);
+      for (size_t i = beg; i < end; ++i) fn(i);
+    });
+  }
+  for (auto& w : workers) w.join();
+}
+
+}  // namespace truss_maint
+
+#endif
@@ -0,0 +1,103 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "defs.h"
+#include "dgraph.h"
+#include "dorder.h"
+#include "dskyline.h"
+
+namespace {
+// answer one query on the layer @tm; the queries are
+//   "edges <K>":     the edges of the (K, l) D-truss, one per line, after
+//                    their # on the first line
+//   "k <V1> <V2>":   the trussness of the edge (V1, V2), or -1 if absent
+//   "community <K> <Q>": the communities of the (K, l) D-truss containing
+//                    the vertex Q, one "<label> <# of edges>" per line,
+//                    after their # on the first line
+//   "members <K> <C>": the edges of the community labeled C, as for "edges"
+//   "vertex <Q>":    the largest K such that the vertex Q is in the (K, l)
+//                    D-truss, or -1 if Q has no edge
+//   "maxk <V1> <V2> <L>": the largest trussness of the edge (V1, V2) at the
+//                    layers from L on, or -1
+//   "maxl <V1> <V2> <X>": the largest layer at which the edge (V1, V2) has
+//                    trussness at least X, or -1
+// the last two are answered by the skyline @sky of all layers
+void Answer(truss_maint::Order& tm, const truss_maint::Skyline& sky,
+            const std::vector<std::string>& q) {
+  if ((2 == q.size() && "edges" == q[0]) ||
+      (3 == q.size() && "members" == q[0])) {
+    const int32_t k = std::atoi(q[1].c_str());
+    const auto edges = 2 == q.size() ? tm.Edges(k) :
+        tm.Members(k, std::strtoull(q[2].c_str(), nullptr, 10));
+    printf("%zu\n", edges.size());
+    for (const auto edge : edges) {
+      printf("%llu %llu\n", static_cast<unsigned long long>(edge.first),
+             static_cast<unsigned long long>(edge.second));
+    }
+  } else if (3 == q.size() && "k" == q[0]) {
+    const auto v1 = std::strtoull(q[1].c_str(), nullptr, 10);
+    const auto v2 = std::strtoull(q[2].c_str(), nullptr, 10);
+    printf("%d\n", tm.Trussness(v1, v2));
+  } else if (3 == q.size() && "community" == q[0]) {
+    const auto comms = tm.Communities(
+        std::atoi(q[1].c_str()), std::strtoull(q[2].c_str(), nullptr, 10));
+    printf("%zu\n", comms.size());
+    for (const auto comm : comms) {
+      printf("%llu %llu\n", static_cast<unsigned long long>(comm.first),
+             static_cast<unsigned long long>(comm.second));
+    }
+  } else if (2 == q.size() && "vertex" == q[0]) {
+    const auto v = std::strtoull(q[1].c_str(), nullptr, 10);
+    printf("%d\n", tm.VertexTrussness(v));
+  } else if (4 == q.size() && ("maxk" == q[0] || "maxl" == q[0])) {
+    const truss_maint::EdgT edge(std::strtoull(q[1].c_str(), nullptr, 10),
+                                 std::strtoull(q[2].c_str(), nullptr, 10));
+    const auto x = std::atol(q[3].c_str());
+    printf("%d\n", "maxk" == q[0] ? sky.MaxK(edge, x) : sky.MaxL(edge, x));
+  } else {
+    printf("invalid query\n");
+  }
+  fflush(stdout);
+}
+}  // namespace
+
+// query the (k, l) D-trusses stored in an index:
+// ./dq <INDEX_PATH> <LAYER> [QUERY], reading queries from stdin if no
+// query is given on the command line; the community labels are valid
+// within one run
+int main(int argc, char** argv) {
+  ASSERT_MSG(argc >= 3, "usage: dq <INDEX_PATH> <LAYER> [QUERY]");
+  const std::string index_file = argv[1];
+  const uint32_t layer = std::atoi(argv[2]);
+  // read the header
+  std::ifstream infile(index_file, std::ios::binary);
+  truss_maint::VidT n = -1;
+  truss_maint::EidT m = -1;
+  infile.read(reinterpret_cast<char*>(&n), sizeof n)
+        .read(reinterpret_cast<char*>(&m), sizeof m);
+  infile.close();
+  ASSERT_MSG(layer < truss_maint::IndexLayers(index_file, m),
+             "the index has no such layer");
+  // only the queried layer is loaded, along with the skyline written next
+  // to the index by dsample
+  truss_maint::Order tm(n, m, index_file, layer);
+  const truss_maint::Skyline sky(index_file + ".sky");
+  if (argc > 3) {
+    Answer(tm, sky, std::vector<std::string>(argv + 3, argv + argc));
+    return 0;
+  }
+  char buf[256];
+  while (nullptr != fgets(buf, sizeof buf, stdin)) {
+    std::vector<std::string> q;
+    for (char* tok = strtok(buf, " \t\r\n"); nullptr != tok;
+         tok = strtok(nullptr, " \t\r\n")) {
+      q.push_back(tok);
+    }
+    if (!q.empty()) Answer(tm, sky, q);
+  }
+}
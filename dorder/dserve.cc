@@ -0,0 +1,419 @@
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "defs.h"
+#include "dgraph.h"
+#include "dorder.h"
+#include "dskyline.h"
+#include "dwal.h"
+
+namespace truss_maint {
+
+namespace {
+// the resident layers of the index
+typedef std::vector<std::unique_ptr<Order>> Layers;
+
+// apply one update to the layers it belongs to; returns an error message,
+// or nullptr if the update has been applied; if @deltas is not nullptr, the
+// state of each edge whose trussness changed is appended to it, layer by
+// layer. The decomposition keeps the edges of flow support at least l in
+// the layer l, so an inserted edge goes to each layer l in which it closes
+// at least l flow triangles (every layer for l = 0), and a deleted edge is
+// removed from the layers that hold it; client input never aborts
+const char* Apply(Layers& layers, const char op, const VidT v1,
+                  const VidT v2, std::vector<WalDelta>* deltas) {
+  if (v1 >= layers[0]->n() || v2 >= layers[0]->n()) return "invalid vertex";
+  if (v1 == v2) return "self-loop";
+  const bool exists = layers[0]->Contain(v1, v2);
+  if ('+' == op && exists) return "duplicate edge";
+  if ('-' == op && !exists) return "missing edge";
+  std::vector<EdgT> changed;
+  for (uint32_t l = 0; l < layers.size(); ++l) {
+    Order& tm = *layers[l];
+    if ('+' == op ? tm.Contain(v1, v2) || tm.Flows(v1, v2) < l
+                  : !tm.Contain(v1, v2)) {
+      continue;
+    }
+    if (nullptr != deltas) tm.Journal(&changed);
+    if ('+' == op) {
+      tm.DiInsert({{v1, v2}});
+    } else {
+      tm.DiRemove(v1, v2);
+    }
+    if (nullptr == deltas) continue;
+    tm.Journal(nullptr);
+    std::sort(changed.begin(), changed.end());
+    changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+    for (const auto edge : changed) {
+      WalDelta d = {l, edge.first, edge.second, -1, 0, 0};
+      tm.State(edge.first, edge.second, d.k, d.ts, d.rem);
+      deltas->push_back(d);
+    }
+    changed.clear();
+  }
+  return nullptr;
+}
+
+// the durable state of serve mode under a path P: the checkpoint P.ckpt
+// names a generation g, whose layers are saved to P.g.<layer>; the updates
+// applied since are logged to the segments P.g.wal, P.(g+1).wal, ...; a
+// new generation is started by rotating the log, after which a forked
+// child saves the layers, as they were at the rotation, and the checkpoint
+struct Durable final {
+  std::string path;
+  // the generation of the checkpoint and the one logged to
+  uint64_t ckpt = 0;
+  uint64_t gen = 0;
+  // the lsn of the last logged update
+  uint64_t lsn = 0;
+  std::unique_ptr<Wal> wal;
+  // the compaction in progress, if any
+  pid_t child = -1;
+  // the size of the last checkpoint; the log is compacted once it outgrows
+  // a quarter of it
+  uint64_t ckpt_bytes = 0;
+};
+
+std::string SnapName(const Durable& d, const uint64_t g, const size_t l) {
+  return d.path + "." + std::to_string(g) + "." + std::to_string(l);
+}
+std::string WalName(const Durable& d, const uint64_t g) {
+  return d.path + "." + std::to_string(g) + ".wal";
+}
+
+// save the layers as generation @g, then point the checkpoint to it
+void SaveGeneration(const Layers& layers, const Durable& d, const uint64_t g) {
+  for (size_t l = 0; l < layers.size(); ++l) {
+    layers[l]->Save(SnapName(d, g, l));
+  }
+  const std::string fn = d.path + ".ckpt";
+  std::ofstream outfile(fn + ".tmp");
+  outfile << g << " " << d.lsn << " " << layers.size() << "\n";
+  outfile.close();
+  ASSERT_MSG(!outfile.fail() && 0 == std::rename((fn + ".tmp").c_str(),
+                                                 fn.c_str()),
+             "cannot write the checkpoint");
+}
+
+// the checkpoint now names generation @g, so drop the files of the older
+// ones
+void DropBefore(Durable& d, const size_t layers, const uint64_t g) {
+  for (uint64_t old = d.ckpt; old < g; ++old) {
+    for (size_t l = 0; l < layers; ++l) unlink(SnapName(d, old, l).c_str());
+    unlink(WalName(d, old).c_str());
+  }
+  d.ckpt = g;
+  d.ckpt_bytes = 0;
+  for (size_t l = 0; l < layers; ++l) {
+    struct stat st;
+    if (0 == stat(SnapName(d, g, l).c_str(), &st)) d.ckpt_bytes += st.st_size;
+  }
+}
+
+// reap the compaction in progress; waits for it if @block
+void Reap(Durable& d, const size_t layers, const bool block) {
+  if (d.child < 0) return;
+  int status = 0;
+  if (waitpid(d.child, &status, block ? 0 : WNOHANG) != d.child) return;
+  d.child = -1;
+  if (WIFEXITED(status) && 0 == WEXITSTATUS(status)) {
+    DropBefore(d, layers, d.gen);
+  } else {
+    // the old checkpoint and all segments since are kept, so nothing is
+    // lost; the next compaction retries
+    fprintf(stderr, "the compaction of generation %" PRIu64 " failed\n",
+            d.gen);
+  }
+}
+
+// start a new generation in the background
+void Compact(const Layers& layers, Durable& d) {
+  if (d.child >= 0) return;
+  ++d.gen;
+  d.wal.reset(new Wal(WalName(d, d.gen)));
+  fflush(nullptr);
+  const pid_t pid = fork();
+  ASSERT_MSG(pid >= 0, "cannot fork the compaction");
+  if (0 == pid) {
+    // the child sees the layers as they were at the rotation
+    SaveGeneration(layers, d, d.gen);
+    _exit(0);
+  }
+  d.child = pid;
+}
+
+// log an applied update
+void Log(const Layers& layers, Durable& d, const char op, const VidT v1,
+         const VidT v2, std::vector<WalDelta>& deltas) {
+  WalRecord rec;
+  rec.lsn = ++d.lsn;
+  rec.updates.push_back({{v1, v2}, '+' == op});
+  rec.deltas.swap(deltas);
+  d.wal->Append(rec);
+  if (d.wal->bytes() > d.ckpt_bytes / 4) Compact(layers, d);
+}
+
+// replay the segments from generation d.ckpt on, checking that each update
+// yields the logged deltas
+void Replay(Layers& layers, Durable& d) {
+  for (uint64_t g = d.ckpt; 0 == access(WalName(d, g).c_str(), F_OK); ++g) {
+    d.gen = g;
+    for (auto& rec : Wal::Read(WalName(d, g))) {
+      ASSERT_MSG(d.lsn + 1 == rec.lsn, "the log has a gap");
+      std::vector<WalDelta> deltas;
+      for (const auto& upd : rec.updates) {
+        const char* err = Apply(layers, upd.second ? '+' : '-',
+                                upd.first.first, upd.first.second, &deltas);
+        ASSERT_MSG(nullptr == err, "the log does not apply to the checkpoint");
+      }
+      const auto key = [](const WalDelta& x) {
+        return std::make_tuple(x.layer, x.v1, x.v2, x.k, x.ts, x.rem);
+      };
+      const auto less = [&key](const WalDelta& x, const WalDelta& y) {
+        return key(x) < key(y);
+      };
+      std::sort(deltas.begin(), deltas.end(), less);
+      std::sort(rec.deltas.begin(), rec.deltas.end(), less);
+      ASSERT_MSG(std::equal(deltas.begin(), deltas.end(), rec.deltas.begin(),
+                            [&key](const WalDelta& x, const WalDelta& y) {
+                              return key(x) == key(y);
+                            }) && deltas.size() == rec.deltas.size(),
+                 "the log does not match the checkpoint");
+      d.lsn = rec.lsn;
+    }
+  }
+}
+
+// answer a query; returns an error message, or nullptr after writing the
+// answer to @out
+const char* Query(Layers& layers, const Skyline& sky, const char op,
+                  const unsigned long long a, const unsigned long long b,
+                  const unsigned long long c, const uint64_t seq, FILE* out) {
+  if ('k' == op) {
+    // "k v1 v2 l": the trussness of (v1, v2) at layer l
+    if (c >= layers.size()) return "invalid layer";
+    fprintf(out, "ok %" PRIu64 " %d\n", seq,
+            layers[c]->Trussness(static_cast<VidT>(a), static_cast<VidT>(b)));
+    return nullptr;
+  }
+  if ('c' == op) {
+    // "c q k l": the communities of the (k, l) D-truss containing q, one
+    // "<label> <# of edges>" per line; labels change with the updates
+    if (c >= layers.size()) return "invalid layer";
+    const auto comms = layers[c]->Communities(static_cast<int32_t>(b),
+                                              static_cast<VidT>(a));
+    fprintf(out, "ok %" PRIu64 " %zu\n", seq, comms.size());
+    for (const auto comm : comms) {
+      fprintf(out, "%llu %llu\n", static_cast<unsigned long long>(comm.first),
+              static_cast<unsigned long long>(comm.second));
+    }
+    return nullptr;
+  }
+  if ('s' == op || 'f' == op) {
+    // "s v1 v2 l": the largest k of (v1, v2) at the layers from l on;
+    // "f v1 v2 x": the largest layer at which (v1, v2) has k >= x
+    const EdgT edge(static_cast<VidT>(a), static_cast<VidT>(b));
+    fprintf(out, "ok %" PRIu64 " %d\n", seq,
+            's' == op ? sky.MaxK(edge, static_cast<uint32_t>(c)) :
+                        sky.MaxL(edge, static_cast<int32_t>(c)));
+    return nullptr;
+  }
+  if ('v' == op) {
+    // "v q l": the largest k such that q is in the (k, l) D-truss
+    if (b >= layers.size()) return "invalid layer";
+    fprintf(out, "ok %" PRIu64 " %d\n", seq,
+            layers[b]->VertexTrussness(static_cast<VidT>(a)));
+    return nullptr;
+  }
+  // "e k l": the edges of the (k, l) D-truss
+  if (b >= layers.size()) return "invalid layer";
+  const auto edges = layers[b]->Edges(static_cast<int32_t>(a));
+  fprintf(out, "ok %" PRIu64 " %zu\n", seq, edges.size());
+  for (const auto edge : edges) {
+    fprintf(out, "%llu %llu\n", static_cast<unsigned long long>(edge.first),
+            static_cast<unsigned long long>(edge.second));
+  }
+  return nullptr;
+}
+
+// the protocol is line-based; a request is either "+ v1 v2" (insertion) or
+// "- v1 v2" (deletion), and is acknowledged by "ok <seq>" once all layers
+// are maintained, or by "err <seq> <reason>" if it is rejected; the queries
+// "k v1 v2 l", "e k l", "c q k l", "v q l", "s v1 v2 l" and "f v1 v2 x" are
+// answered by "ok <seq> <answer>" (see Query); "save <path>" saves a
+// snapshot of every layer l to <path>.l and is acknowledged by "ok <seq>";
+// with a durable state @d, every applied update is logged before it is
+// acknowledged, and "checkpoint" starts a compaction of the log;
+// "quit" ends the session
+void ServeStream(Layers& layers, const Skyline& sky, Durable* d, FILE* in,
+                 FILE* out, uint64_t& seq) {
+  char* line = nullptr;
+  size_t cap = 0;
+  while (getline(&line, &cap, in) > 0) {
+    char op = 0;
+    unsigned long long a = 0, b = 0, c = 0;
+    const int cnt = sscanf(line, " %c %llu %llu %llu", &op, &a, &b, &c);
+    if (cnt <= 0) continue;
+    if (1 == cnt && 'q' == op) break;
+    const uint64_t cur = ++seq;
+    const char* err = "malformed request";
+    if (nullptr != d) Reap(*d, layers.size(), false);
+    char path[4096];
+    if (1 == sscanf(line, " %4095s", path) && nullptr != d &&
+        0 == strcmp(path, "checkpoint")) {
+      Compact(layers, *d);
+      fprintf(out, "ok %" PRIu64 "\n", cur);
+      err = nullptr;
+    } else if (1 == sscanf(line, " save %4095s", path)) {
+      for (size_t l = 0; l < layers.size(); ++l) {
+        layers[l]->Save(std::string(path) + "." + std::to_string(l));
+      }
+      fprintf(out, "ok %" PRIu64 "\n", cur);
+      err = nullptr;
+    } else if (3 == cnt && ('+' == op || '-' == op)) {
+      const VidT v1 = static_cast<VidT>(a);
+      const VidT v2 = static_cast<VidT>(b);
+      std::vector<WalDelta> deltas;
+      err = Apply(layers, op, v1, v2, nullptr == d ? nullptr : &deltas);
+      if (nullptr == err && nullptr != d) Log(layers, *d, op, v1, v2, deltas);
+      if (nullptr == err) fprintf(out, "ok %" PRIu64 "\n", cur);
+    } else if ((4 == cnt && ('k' == op || 'c' == op || 's' == op ||
+                             'f' == op)) ||
+               (3 == cnt && ('e' == op || 'v' == op))) {
+      err = Query(layers, sky, op, a, b, c, cur, out);
+    }
+    if (nullptr != err) fprintf(out, "err %" PRIu64 " %s\n", cur, err);
+    fflush(out);
+  }
+  free(line);
+}
+
+// serve the loaded layers; @beg is the time the loading started
+void Serve(Layers& layers, const std::string& socket_file, Durable* d,
+           const std::chrono::steady_clock::time_point beg) {
+  const uint32_t cnt = layers.size();
+  // the skyline follows the trussness of every layer
+  Skyline sky(cnt);
+  for (uint32_t curf = 0; curf < cnt; ++curf) {
+    layers[curf]->Attach(&sky, curf);
+  }
+  const auto end = std::chrono::steady_clock::now();
+  fprintf(stderr, "loaded %u layers in %f ms\n", cnt,
+          std::chrono::duration<double, std::milli>(end - beg).count());
+  uint64_t seq = 0;
+  if (socket_file.empty()) {
+    ServeStream(layers, sky, d, stdin, stdout, seq);
+    if (nullptr != d) Reap(*d, layers.size(), true);
+    return;
+  }
+  // serve the clients of the socket one by one
+  const int sfd = socket(AF_UNIX, SOCK_STREAM, 0);
+  ASSERT_MSG(sfd >= 0, "cannot create the socket");
+  sockaddr_un addr;
+  std::memset(&addr, 0, sizeof addr);
+  addr.sun_family = AF_UNIX;
+  ASSERT_MSG(socket_file.size() < sizeof addr.sun_path, "socket path too long");
+  std::strcpy(addr.sun_path, socket_file.c_str());
+  unlink(socket_file.c_str());
+  ASSERT_MSG(0 == bind(sfd, reinterpret_cast<sockaddr*>(&addr), sizeof addr),
+             "cannot bind the socket");
+  ASSERT_MSG(0 == listen(sfd, 16), "cannot listen on the socket");
+  fprintf(stderr, "listening on %s\n", socket_file.c_str());
+  while (true) {
+    const int cfd = accept(sfd, nullptr, nullptr);
+    if (cfd < 0) continue;
+    FILE* in = fdopen(cfd, "r");
+    FILE* out = fdopen(dup(cfd), "w");
+    ServeStream(layers, sky, d, in, out, seq);
+    fclose(out);
+    fclose(in);
+  }
+}
+}  // namespace
+
+void mainServe(VidT n, EidT m,
+               const std::string index_file,
+               const std::string socket_file,
+               const std::string state_file) {
+  // load all layers once
+  const auto beg = std::chrono::steady_clock::now();
+  const uint32_t cnt = IndexLayers(index_file, m);
+  ASSERT_MSG(cnt > 0, "the index has no layer");
+  Layers layers;
+  for (uint32_t curf = 0; curf < cnt; ++curf) {
+    layers.emplace_back(new Order(n, m, index_file, curf));
+  }
+  if (state_file.empty()) {
+    Serve(layers, socket_file, nullptr, beg);
+    return;
+  }
+  // start the durable state from generation 0
+  Durable d;
+  d.path = state_file;
+  ASSERT_MSG(0 != access((d.path + ".ckpt").c_str(), F_OK),
+             "the state path is in use; restore from it instead");
+  SaveGeneration(layers, d, 0);
+  DropBefore(d, layers.size(), 0);
+  unlink(WalName(d, 0).c_str());
+  d.wal.reset(new Wal(WalName(d, 0)));
+  Serve(layers, socket_file, &d, beg);
+}
+
+void mainRestore(const std::string snapshot_file,
+                 const std::string socket_file) {
+  const auto beg = std::chrono::steady_clock::now();
+  Layers layers;
+  std::ifstream ckpt(snapshot_file + ".ckpt");
+  if (!ckpt.is_open()) {
+    // restore the layers <snapshot_file>.0, <snapshot_file>.1, ... as saved
+    for (uint32_t curf = 0; ; ++curf) {
+      const std::string fn = snapshot_file + "." + std::to_string(curf);
+      if (0 != access(fn.c_str(), R_OK)) break;
+      layers.emplace_back(new Order(fn));
+    }
+    ASSERT_MSG(!layers.empty(), "no snapshot to restore");
+    Serve(layers, socket_file, nullptr, beg);
+    return;
+  }
+  // recover a durable state: load its checkpoint and replay the log
+  Durable d;
+  d.path = snapshot_file;
+  size_t cnt = 0;
+  ckpt >> d.ckpt >> d.lsn >> cnt;
+  ASSERT_MSG(!ckpt.fail() && cnt > 0, "invalid checkpoint");
+  ckpt.close();
+  for (size_t l = 0; l < cnt; ++l) {
+    layers.emplace_back(new Order(SnapName(d, d.ckpt, l)));
+  }
+  d.gen = d.ckpt;
+  Replay(layers, d);
+  fprintf(stderr, "recovered generation %" PRIu64 " up to update %" PRIu64
+          "\n", d.ckpt, d.lsn);
+  // drop the leftovers of a compaction that completed before a crash
+  for (uint64_t g = d.ckpt; g-- > 0 &&
+       0 == access(WalName(d, g).c_str(), F_OK); ) {
+    for (size_t l = 0; l < cnt; ++l) unlink(SnapName(d, g, l).c_str());
+    unlink(WalName(d, g).c_str());
+  }
+  DropBefore(d, cnt, d.ckpt);
+  // the last segment may end with a torn record, so logging goes on in a
+  // new generation
+  Compact(layers, d);
+  Serve(layers, socket_file, &d, beg);
+}
+
+}  // namespace truss_maint
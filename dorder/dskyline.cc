@@ -0,0 +1,96 @@
+#include "dskyline.h"
+
+#include <algorithm>
+#include <fstream>
+
+#include "defs.h"
+
+namespace truss_maint {
+
+Skyline::Skyline(const std::string& fn) {
+  std::ifstream infile(fn, std::ios::binary);
+  ASSERT_MSG(infile.good(), "cannot open the skyline file");
+  VidT n = 0;
+  EidT m = 0, layers = 0;
+  infile.read(reinterpret_cast<char*>(&n), sizeof n)
+        .read(reinterpret_cast<char*>(&m), sizeof m)
+        .read(reinterpret_cast<char*>(&layers), sizeof layers);
+  layers_ = layers;
+  runs_.reserve(m);
+  for (EidT e = 0, buf[3]; e < m; ++e) {
+    infile.read(reinterpret_cast<char*>(buf), sizeof buf);
+    auto& runs = runs_[{buf[0], buf[1]}];
+    runs.resize(buf[2]);
+    for (auto& run : runs) {
+      EidT r[2];
+      infile.read(reinterpret_cast<char*>(r), sizeof r);
+      run.last = static_cast<uint32_t>(r[0]);
+      run.k = static_cast<int32_t>(r[1]);
+    }
+    ASSERT_MSG(!runs.empty() && layers_ - 1 == runs.back().last,
+               "corrupted skyline file");
+  }
+  ASSERT_MSG(infile.good(), "truncated skyline file");
+}
+
+void Skyline::Set(const EdgT edge, const uint32_t l, const int32_t k) {
+  ASSERT(l < layers_);
+  auto it = runs_.find(edge);
+  if (runs_.end() == it) {
+    if (-1 == k) return;
+    it = runs_.emplace(edge, std::vector<Run>{{layers_ - 1, -1}}).first;
+  }
+  auto& runs = it->second;
+  const size_t i = std::lower_bound(runs.begin(), runs.end(), l,
+      [](const Run& run, const uint32_t l) { return run.last < l; }) -
+      runs.begin();
+  if (runs[i].k == k) return;
+  // split the run containing l into [beg, l), [l, l] and (l, last], then
+  // merge the runs with equal trussness
+  const uint32_t beg = 0 == i ? 0 : runs[i - 1].last + 1;
+  std::vector<Run> mid;
+  if (beg < l) mid.push_back({l - 1, runs[i].k});
+  mid.push_back({l, k});
+  if (l < runs[i].last) mid.push_back({runs[i].last, runs[i].k});
+  runs.erase(runs.begin() + i);
+  runs.insert(runs.begin() + i, mid.begin(), mid.end());
+  size_t j = 0;
+  for (size_t r = 1; r < runs.size(); ++r) {
+    if (runs[j].k == runs[r].k) {
+      runs[j].last = runs[r].last;
+    } else {
+      runs[++j] = runs[r];
+    }
+  }
+  runs.resize(j + 1);
+  if (1 == runs.size() && -1 == runs[0].k) runs_.erase(it);
+}
+
+int32_t Skyline::MaxK(const EdgT edge, const uint32_t l) const {
+  const auto it = runs_.find(edge);
+  if (runs_.end() == it || l >= layers_) return -1;
+  // the trussness is non-increasing in l, so the run containing l has the
+  // largest trussness among the layers from l on
+  const auto& runs = it->second;
+  return std::lower_bound(runs.begin(), runs.end(), l,
+      [](const Run& run, const uint32_t l) { return run.last < l; })->k;
+}
+
+int32_t Skyline::MaxL(const EdgT edge, const int32_t x) const {
+  const auto it = runs_.find(edge);
+  if (runs_.end() == it) return -1;
+  // the last run with trussness at least x, where the layers without the
+  // edge (trussness -1) never count
+  const auto& runs = it->second;
+  const int32_t y = std::max(x, 0);
+  const auto r = std::partition_point(runs.begin(), runs.end(),
+      [y](const Run& run) { return run.k >= y; });
+  return runs.begin() == r ? -1 : static_cast<int32_t>((r - 1)->last);
+}
+
+std::vector<Skyline::Run> Skyline::Runs(const EdgT edge) const {
+  const auto it = runs_.find(edge);
+  return runs_.end() == it ? std::vector<Run>() : it->second;
+}
+
+}  // namespace truss_maint
@@ -0,0 +1,64 @@
+#ifndef TRUSS_MAINT_SKYLINE_H_
+#define TRUSS_MAINT_SKYLINE_H_
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "dgraph.h"
+
+namespace truss_maint {
+// the (k, l) skyline of every edge across the flow layers; the D-truss of a
+// layer contains the D-truss of the next one, so the trussness of an edge is
+// non-increasing in l, and it is kept as runs of layers with the same
+// trussness; the last layer of each run with its trussness is then exactly
+// the Pareto frontier of the (k, l) pairs of the edge
+class Skyline final {
+ public:
+  // a run: the layers up to @last (from the end of the previous run) have
+  // trussness @k
+  struct Run final {
+    uint32_t last;
+    int32_t k;
+  };
+  // param layers: the # of layers
+  explicit Skyline(const uint32_t layers) : layers_(layers) {}
+  Skyline(const Skyline&) = delete;
+  Skyline& operator=(const Skyline&) = delete;
+  // load the skyline written by Decomp::SWriteToFile
+  explicit Skyline(const std::string& fn);
+  // the trussness of the edge at layer l becomes k (-1 if the edge is
+  // absent); in O(# of runs of the edge)
+  void Set(const EdgT edge, const uint32_t l, const int32_t k);
+  // queries in O(log # of runs of the edge)
+  // the largest k such that the edge is in the (k, l') D-truss for some
+  // l' >= l, or -1 if there is none
+  int32_t MaxK(const EdgT edge, const uint32_t l) const;
+  // the largest l such that the edge is in the (k, l) D-truss for some
+  // k >= x, or -1 if there is none
+  int32_t MaxL(const EdgT edge, const int32_t x) const;
+  // the runs of the edge, i.e., its skyline; empty if the edge is absent
+  // from all layers
+  std::vector<Run> Runs(const EdgT edge) const;
+  uint32_t layers() const { return layers_; }
+  // the # of edges with at least one present layer
+  size_t size() const { return runs_.size(); }
+
+ private:
+  struct EdgHash final {
+    size_t operator()(const EdgT& edge) const {
+      return std::hash<uint64_t>()(
+          static_cast<uint64_t>(edge.first) * 0x9E3779B97F4A7C15ULL ^
+          static_cast<uint64_t>(edge.second));
+    }
+  };
+  uint32_t layers_;
+  std::unordered_map<EdgT, std::vector<Run>, EdgHash> runs_;
+};
+
+}  // namespace truss_maint
+
+#endif
@@ -0,0 +1,157 @@
+#ifndef TRUSS_MAINT_SNAP_H_
+#define TRUSS_MAINT_SNAP_H_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "defs.h"
+
+namespace truss_maint {
+// the types written as raw bytes; std::pair is not trivially copyable
+// but is safe to copy bytewise when its members are
+template <typename T>
+constexpr bool IsRaw() {
+  return std::is_standard_layout<T>::value &&
+         std::is_trivially_destructible<T>::value;
+}
+// a binary snapshot: the magic number and the ID width, followed by plain
+// values and arrays; an array is its # of entries followed by its raw
+// entries, and every item is padded to 8 bytes, so that all arrays of the
+// file stay aligned once it is mapped
+const uint64_t kSnapMagic = 0x31504e5353555254ULL;  // "TRUSSNP1"
+
+class SnapWriter final {
+ public:
+  SnapWriter(const std::string& fn, const uint32_t id_width)
+      : out_(fn, std::ios::binary) {
+    ASSERT_MSG(out_.is_open(), "cannot create the snapshot");
+    Put(kSnapMagic);
+    Put(id_width);
+  }
+  template <typename T>
+  void Put(const T& val) {
+    static_assert(IsRaw<T>(), "raw values only");
+    Write(&val, sizeof val);
+  }
+  template <typename T>
+  void PutVec(const std::vector<T>& vec) {
+    static_assert(IsRaw<T>(), "raw values only");
+    Put(uint64_t{vec.size()});
+    Write(vec.data(), vec.size() * sizeof(T));
+  }
+  // nested arrays are stored as the array of their sizes and the
+  // concatenation of their entries
+  template <typename T>
+  void PutNested(const std::vector<std::vector<T>>& vecs) {
+    std::vector<uint64_t> sizes;
+    uint64_t total = 0;
+    for (const auto& vec : vecs) {
+      sizes.push_back(vec.size());
+      total += vec.size();
+    }
+    PutVec(sizes);
+    Put(total);
+    for (const auto& vec : vecs) {
+      out_.write(reinterpret_cast<const char*>(vec.data()),
+                 vec.size() * sizeof(T));
+    }
+    Pad(total * sizeof(T));
+  }
+  // flush the snapshot; fails if any write failed
+  void Close() {
+    out_.close();
+    ASSERT_MSG(!out_.fail(), "cannot write the snapshot");
+  }
+
+ private:
+  void Write(const void* data, const size_t bytes) {
+    out_.write(reinterpret_cast<const char*>(data), bytes);
+    Pad(bytes);
+  }
+  void Pad(const size_t bytes) {
+    static const char zeros[8] = {};
+    out_.write(zeros, (8 - bytes % 8) % 8);
+  }
+  std::ofstream out_;
+};
+
+class SnapReader final {
+ public:
+  SnapReader(const std::string& fn, const uint32_t id_width) {
+    const int fd = open(fn.c_str(), O_RDONLY);
+    ASSERT_MSG(fd >= 0, "cannot open the snapshot");
+    struct stat st;
+    ASSERT_MSG(0 == fstat(fd, &st), "cannot stat the snapshot");
+    size_ = st.st_size;
+    void* base = size_ > 0 ?
+        mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+    ASSERT_MSG(MAP_FAILED != base, "cannot map the snapshot");
+    base_ = static_cast<const char*>(base);
+    // the snapshot is read once from the front to the back
+    madvise(base, size_, MADV_SEQUENTIAL);
+    ASSERT_MSG(kSnapMagic == Get<uint64_t>(), "not a snapshot");
+    ASSERT_MSG(id_width == Get<uint32_t>(),
+               "the snapshot was written with another ID width");
+  }
+  SnapReader(const SnapReader&) = delete;
+  SnapReader& operator=(const SnapReader&) = delete;
+  ~SnapReader() { munmap(const_cast<char*>(base_), size_); }
+  template <typename T>
+  T Get() {
+    static_assert(IsRaw<T>(), "raw values only");
+    T val;
+    Read(&val, sizeof val);
+    return val;
+  }
+  template <typename T>
+  void GetVec(std::vector<T>& vec) {
+    static_assert(IsRaw<T>(), "raw values only");
+    vec.resize(Get<uint64_t>());
+    Read(vec.data(), vec.size() * sizeof(T));
+  }
+  template <typename T>
+  void GetNested(std::vector<std::vector<T>>& vecs) {
+    std::vector<uint64_t> sizes;
+    GetVec(sizes);
+    uint64_t total = Get<uint64_t>();
+    ASSERT_MSG(pos_ + total * sizeof(T) <= size_, "truncated snapshot");
+    vecs.resize(sizes.size());
+    const T* p = reinterpret_cast<const T*>(base_ + pos_);
+    for (size_t i = 0; i < sizes.size(); ++i) {
+      ASSERT_MSG(sizes[i] <= total, "corrupted snapshot");
+      vecs[i].assign(p, p + sizes[i]);
+      p += sizes[i];
+      total -= sizes[i];
+    }
+    ASSERT_MSG(0 == total, "corrupted snapshot");
+    Skip(reinterpret_cast<const char*>(p) - (base_ + pos_));
+  }
+  // whether the whole snapshot has been read
+  bool Done() const { return pos_ == size_; }
+
+ private:
+  void Read(void* data, const size_t bytes) {
+    ASSERT_MSG(pos_ + bytes <= size_, "truncated snapshot");
+    if (bytes > 0) std::memcpy(data, base_ + pos_, bytes);
+    Skip(bytes);
+  }
+  void Skip(const size_t bytes) {
+    pos_ += bytes + (8 - bytes % 8) % 8;
+  }
+  const char* base_ = nullptr;
+  size_t size_ = 0;
+  size_t pos_ = 0;
+};
+
+}  // namespace truss_maint
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef TRUSS_MAINT_STATS_H_
+#define TRUSS_MAINT_STATS_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace truss_maint {
+// the hot-path counters are updated under "if (kStats)", so building with
+// -DTRUSS_NO_STATS (make NOSTATS=1) compiles them out and they stay zero
+#ifdef TRUSS_NO_STATS
+const bool kStats = false;
+#else
+const bool kStats = true;
+#endif
+
+// the # of heap allocations in the process so far, counted by all threads
+// with the operator new of dalloc.cc; only the binaries that link it count
+// them (db and dh, and dm if built with make ALLOCS=1), the others stay at 0
+extern std::atomic<uint64_t> allocation_count;
+uint64_t Allocations();
+
+// the calls of an update routine
+struct OpStats final {
+  uint64_t calls = 0;
+  uint64_t edges = 0;          // the edges given to the calls
+  uint64_t triangles = 0;      // the triangles they enumerated
+  uint64_t max_triangles = 0;  // the most triangles enumerated by a call
+  uint64_t allocations = 0;    // the heap allocations made by the calls
+  uint64_t max_allocations = 0;
+  void Count(const uint64_t es, const uint64_t tris, const uint64_t allocs) {
+    ++calls;
+    edges += es;
+    triangles += tris;
+    if (tris > max_triangles) max_triangles = tris;
+    allocations += allocs;
+    if (allocs > max_allocations) max_allocations = allocs;
+  }
+};
+// the counters of an Order since its construction
+struct Stats final {
+  OpStats insert;        // DiInsert
+  OpStats batch_insert;  // DiBatchInsert
+  OpStats remove;        // DiRemove
+  OpStats batch_remove;  // DiBatchRemove
+  OpStats redecompose;   // Redecompose
+  // order maintenance
+  uint64_t om_inserts = 0;
+  uint64_t om_splits = 0;          // full groups split in two
+  uint64_t om_relabels = 0;        // relabelings of a range of group tags
+  uint64_t om_relabel_groups = 0;  // the groups relabeled by them
+  uint64_t om_relabel_max = 0;     // the most groups relabeled at once
+  uint64_t om_retags = 0;          // relabelings of the tags in a group
+  // heap maintenance
+  uint64_t hp_pushes = 0;
+  uint64_t hp_pops = 0;
+  // cand[k] is the total size of the candidate sets entering the level k of
+  // DiInsert and DiBatchInsert, and cand_max[k] the largest of them
+  std::vector<uint64_t> cand;
+  std::vector<uint64_t> cand_max;
+  // depth[d] is the # of calls of DiRemove and DiBatchRemove whose cascade
+  // reached depth d; the edges demoted by the removed edges are at depth 1,
+  // those demoted by an edge at depth d at depth d + 1, and a call demoting
+  // no edge counts at depth 0
+  std::vector<uint64_t> depth;
+  uint64_t cascade = 0;  // the edges processed by the cascades
+  // the changes of the trussness of live edges by the updates, but not by
+  // Redecompose; an edge demoted by two levels in a call counts twice
+  uint64_t changed = 0;
+};
+// the counters of a Graph since its construction
+struct GraphStats final {
+  uint64_t inserts = 0;  // DiInsert
+  uint64_t removes = 0;  // DiRemove
+  // the adjacency entries scanned to find the position of an edge, and
+  // those shifted to make room for it or to fill its gap
+  uint64_t scanned = 0;
+  uint64_t shifted = 0;
+};
+
+}  // namespace truss_maint
+
+#endif
@@ -15,37 +15,68 @@
 
 // a sample program
 int main(int argc, char** argv) {
-  ASSERT(7 == argc);
+  ASSERT(argc >= 2);
+  if (std::string(argv[1]) == "serve") {
+    // resident mode: ./dm serve <INDEX_PATH> [SOCKET_PATH [STATE_PATH]],
+    // where the socket path "-" stands for stdin
+    ASSERT(3 <= argc && argc <= 5);
+    std::ifstream infile(argv[2], std::ios::binary);
+    truss_maint::VidT n = -1;
+    truss_maint::EidT m = -1;
+    infile.read(reinterpret_cast<char*>(&n), sizeof n)
+          .read(reinterpret_cast<char*>(&m), sizeof m);
+    infile.close();
+    const std::string socket_file = argc >= 4 ? argv[3] : "";
+    truss_maint::mainServe(n, m, argv[2], "-" == socket_file ? "" : socket_file,
+                           5 == argc ? argv[4] : "");
+    return 0;
+  }
+  if (std::string(argv[1]) == "restore") {
+    // resident mode from snapshots or a durable state:
+    // ./dm restore <SNAPSHOT_PATH | STATE_PATH> [SOCKET_PATH]
+    ASSERT(3 == argc || 4 == argc);
+    truss_maint::mainRestore(argv[2], 4 == argc ? argv[3] : "");
+    return 0;
+  }
+  // the optional last argument is the path of the snapshots to save
+  ASSERT(7 == argc || 8 == argc);
   const std::string op = argv[1];
   const std::string old_index_file = argv[2];
   const std::string update_file = argv[3];
   const std::string ground_truth_file = argv[4];
   const std::string final_file = argv[5];
   const std::string f_index_file = argv[6];
+  const std::string snapshot_file = 8 == argc ? argv[7] : "";
   printf("*****************************************************************\n");
   printf("old index file: %s\n", old_index_file.c_str());
   printf("update file: %s\n", update_file.c_str());
   printf("ground truth file: %s\n", ground_truth_file.c_str());
   printf("final file: %s\n", final_file.c_str());
   printf("f index file: %s\n", f_index_file.c_str());
+  if (!snapshot_file.empty()) {
+    printf("snapshot file: %s\n", snapshot_file.c_str());
+  }
   printf("*****************************************************************\n");
   // read the header
   std::ifstream infile(old_index_file, std::ios::binary);
-  uint32_t n = -1, m = -1;  // # of vertices and edges
+  truss_maint::VidT n = -1;  // # of vertices
+  truss_maint::EidT m = -1;  // # of edges
   infile.read(reinterpret_cast<char*>(&n), sizeof n)
         .read(reinterpret_cast<char*>(&m), sizeof m);
   infile.close();
   // read the graph and the index
-  // We set the param "l" to "m * 2" here, where "l" is the maximum number of
-  // edges that a graph can hold. We impose this constraint only for ease of
-  // implementation. TODO: remove this constraint in the future.
+  // Each layer starts with "l = m" edge IDs; the capacity grows with the
+  // insertions and is compacted after heavy deletions.
   
   // apply the updates
+  // the total includes the verification; the phases tell them apart
   const auto beg = std::chrono::steady_clock::now();
+  truss_maint::Profile prof;
   std::vector<std::vector<truss_maint::ArrayEntry>> adj_out;
   std::vector<uint32_t> fs_; uint32_t maxf= 0;
-  truss_maint::mainFlow(final_file, adj_out, fs_, maxf);
-  truss_maint::mainDOrder(n, m, adj_out, fs_, maxf, old_index_file, update_file, ground_truth_file, final_file, f_index_file, op);
+  truss_maint::mainFlow(final_file, adj_out, fs_, maxf, prof);
+  truss_maint::mainDOrder(n, m, adj_out, fs_, maxf, old_index_file, update_file, ground_truth_file, final_file, f_index_file, op,
+                          snapshot_file, prof);
   const auto end = std::chrono::steady_clock::now();
   const auto dif = end - beg;
   printf("Applying the updates costs \x1b[1;31m%f\x1b[0m ms.\n",
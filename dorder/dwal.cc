@@ -0,0 +1,114 @@
+#include "dwal.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fstream>
+
+#include "defs.h"
+
+namespace truss_maint {
+
+namespace {
+const uint64_t kWalMagic = 0x314c4157535354ULL;  // "TSSWAL1"
+// FNV-1a over the lsn and the payload
+uint64_t Checksum(const uint64_t lsn, const std::vector<EidT>& words) {
+  uint64_t h = 14695981039346656037ULL;
+  for (int i = 0; i < 8; ++i) {
+    h = (h ^ (lsn >> (8 * i) & 0xff)) * 1099511628211ULL;
+  }
+  const char* p = reinterpret_cast<const char*>(words.data());
+  for (size_t i = 0; i < words.size() * sizeof(EidT); ++i) {
+    h = (h ^ static_cast<unsigned char>(p[i])) * 1099511628211ULL;
+  }
+  return h;
+}
+}  // namespace
+
+Wal::Wal(const std::string& fn) {
+  fd_ = open(fn.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+  ASSERT_MSG(fd_ >= 0, "cannot open the log");
+  struct stat st;
+  ASSERT_MSG(0 == fstat(fd_, &st), "cannot stat the log");
+  bytes_ = st.st_size;
+}
+
+Wal::~Wal() { close(fd_); }
+
+void Wal::Append(const WalRecord& rec) {
+  // the frame is (magic, lsn, # of words, checksum) and the payload is the
+  // updates as (v1, v2, insertion) and the deltas as (layer, v1, v2, k, ts,
+  // rem), each after its #
+  std::vector<EidT> words;
+  words.push_back(rec.updates.size());
+  for (const auto& upd : rec.updates) {
+    words.insert(words.end(), {upd.first.first, upd.first.second,
+                               static_cast<EidT>(upd.second)});
+  }
+  words.push_back(rec.deltas.size());
+  for (const auto& d : rec.deltas) {
+    words.insert(words.end(), {d.layer, d.v1, d.v2, static_cast<EidT>(d.k),
+                               d.ts, d.rem});
+  }
+  const uint64_t header[] = {kWalMagic, rec.lsn, words.size(),
+                             Checksum(rec.lsn, words)};
+  std::vector<char> buf(sizeof header + words.size() * sizeof(EidT));
+  std::copy(reinterpret_cast<const char*>(header),
+            reinterpret_cast<const char*>(header) + sizeof header, buf.data());
+  std::copy(reinterpret_cast<const char*>(words.data()),
+            reinterpret_cast<const char*>(words.data() + words.size()),
+            buf.data() + sizeof header);
+  // one write per record, so a crash tears at most the last one
+  for (size_t off = 0; off < buf.size(); ) {
+    const ssize_t w = write(fd_, buf.data() + off, buf.size() - off);
+    ASSERT_MSG(w > 0, "cannot append to the log");
+    off += w;
+  }
+  ASSERT_MSG(0 == fdatasync(fd_), "cannot sync the log");
+  bytes_ += buf.size();
+}
+
+std::vector<WalRecord> Wal::Read(const std::string& fn) {
+  std::vector<WalRecord> recs;
+  std::ifstream infile(fn, std::ios::binary);
+  uint64_t header[4];
+  while (infile.read(reinterpret_cast<char*>(header), sizeof header)) {
+    if (kWalMagic != header[0] || header[2] > (uint64_t{1} << 40)) break;
+    std::vector<EidT> words(header[2]);
+    if (!infile.read(reinterpret_cast<char*>(words.data()),
+                     words.size() * sizeof(EidT))) {
+      break;
+    }
+    if (Checksum(header[1], words) != header[3]) break;
+    // decode; a record that does not parse ends the segment as well
+    size_t p = 0;
+    const auto next = [&words, &p](EidT& w) {
+      if (p >= words.size()) return false;
+      w = words[p++];
+      return true;
+    };
+    WalRecord rec;
+    rec.lsn = header[1];
+    EidT cnt = 0;
+    bool ok = next(cnt);
+    for (EidT i = 0; ok && i < cnt; ++i) {
+      EidT v1 = 0, v2 = 0, ins = 0;
+      ok = next(v1) && next(v2) && next(ins);
+      rec.updates.push_back({{v1, v2}, 0 != ins});
+    }
+    ok = ok && next(cnt);
+    for (EidT i = 0; ok && i < cnt; ++i) {
+      EidT w[6] = {};
+      for (EidT& x : w) ok = ok && next(x);
+      rec.deltas.push_back({static_cast<uint32_t>(w[0]), w[1], w[2],
+                            static_cast<int32_t>(w[3]),
+                            static_cast<uint32_t>(w[4]),
+                            static_cast<uint32_t>(w[5])});
+    }
+    if (!ok || p != words.size()) break;
+    recs.push_back(std::move(rec));
+  }
+  return recs;
+}
+
+}  // namespace truss_maint
@@ -0,0 +1,52 @@
+#ifndef TRUSS_MAINT_WAL_H_
+#define TRUSS_MAINT_WAL_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "dgraph.h"
+#include "dorder.h"
+
+namespace truss_maint {
+// the state of an edge in one layer after a logged batch; k = -1 if the
+// edge has been removed
+struct WalDelta final {
+  uint32_t layer;
+  VidT v1;
+  VidT v2;
+  int32_t k;
+  uint32_t ts;
+  uint32_t rem;
+};
+// a logged batch: the updates applied to every layer, and the resulting
+// state of each edge whose trussness changed in some layer
+struct WalRecord final {
+  uint64_t lsn;
+  std::vector<UpdT> updates;
+  std::vector<WalDelta> deltas;
+};
+// a segment of the write-ahead log; a record is framed by its size and a
+// checksum, and is on disk once Append returns
+class Wal final {
+ public:
+  // open the segment @fn for appending, creating it if needed
+  explicit Wal(const std::string& fn);
+  Wal(const Wal&) = delete;
+  Wal& operator=(const Wal&) = delete;
+  ~Wal();
+  void Append(const WalRecord& rec);
+  // the # of bytes in the segment
+  uint64_t bytes() const { return bytes_; }
+  // read the records of the segment @fn; a torn or corrupted record, as
+  // left by a crash while appending, ends the segment
+  static std::vector<WalRecord> Read(const std::string& fn);
+
+ private:
+  int fd_;
+  uint64_t bytes_;
+};
+
+}  // namespace truss_maint
+
+#endif
@@ -0,0 +1,62 @@
+#!/bin/bash
+# End-to-end scaling harness: generates R-MAT graphs and update streams with
+# dg, decomposes them with dsample, and applies each stream with dh for
+# every batch size and thread count. One JSON object per run is appended to
+# <OUT_DIR>/results.jsonl; the generated files are kept in OUT_DIR.
+#
+# usage: ./scaling.sh [OUT_DIR]
+# The sweep is set by the environment (defaults in brackets):
+#   SCALES [10 12 14]    log2 of the # of vertices
+#   EDGE_FACTOR [8]      edges per vertex
+#   RECIPROCITY [0.2]    probability that an edge is reciprocated
+#   CYCLES [0.2]         fraction of edges that close a 2-path
+#   KINDS [insert delete mixed]
+#   UPDATES [1024]       updates per stream
+#   BATCHES [1 16 256 1024]
+#   THREADS [1 2 4 8]
+#   SEED [1]
+set -e
+HERE=$(cd "$(dirname "$0")" && pwd)
+OUT=${1:-scaling.out}
+SCALES=${SCALES:-10 12 14}
+EDGE_FACTOR=${EDGE_FACTOR:-8}
+RECIPROCITY=${RECIPROCITY:-0.2}
+CYCLES=${CYCLES:-0.2}
+KINDS=${KINDS:-insert delete mixed}
+UPDATES=${UPDATES:-1024}
+BATCHES=${BATCHES:-1 16 256 1024}
+THREADS=${THREADS:-1 2 4 8}
+SEED=${SEED:-1}
+
+make -s -C "$HERE/../ddecomp" >/dev/null
+make -s -C "$HERE" gen >/dev/null
+make -s -C "$HERE" harness >/dev/null
+mkdir -p "$OUT"
+RESULTS="$OUT/results.jsonl"
+
+ms() { echo $(( ($(date +%s%N) - $1) / 1000000 )); }
+
+for scale in $SCALES; do
+  graph="$OUT/g$scale.txt"
+  "$HERE/dg" graph "$scale" $(( (1 << scale) * EDGE_FACTOR )) \
+      "$RECIPROCITY" "$CYCLES" "$SEED" "$graph" >&2
+  for kind in $KINDS; do
+    pre="$OUT/g$scale.$kind"
+    "$HERE/dg" updates "$graph" "$kind" "$UPDATES" "$SEED" "$pre"
+    # the index to update and the ground truth
+    for part in base final; do
+      beg=$(date +%s%N)
+      "$HERE/../ddecomp/dsample" "$pre.$part" "$pre.$part.idx" >/dev/null
+      echo "{\"tool\": \"dsample\", \"graph\": \"$pre.$part\"," \
+           "\"scale\": $scale, \"ms\": $(ms "$beg")}" >> "$RESULTS"
+    done
+    for batch in $BATCHES; do
+      for t in $THREADS; do
+        echo "scale $scale, $kind, batch $batch, $t threads" >&2
+        TRUSS_THREADS=$t "$HERE/dh" "$pre.base.idx" "$pre.upd" "$kind" \
+            "$batch" "$pre.final.idx" >> "$RESULTS"
+      done
+    done
+  done
+done
+echo "results in $RESULTS" >&2